@@ -3,6 +3,7 @@
 #define PCP_HPP
 
 #include <bitset>
+#include <cstdint>
 #include <vector>
 
 namespace pcp {
@@ -11,7 +12,16 @@ namespace pcp {
 const size_t BinaryDomainSize = 3;
 
 // type used to represent variable index
+// 64 bits by default, PCP_VARIABLE_BITS=32 halves the index footprint of small instances
+#if !defined(PCP_VARIABLE_BITS) || PCP_VARIABLE_BITS == 64
+using Variable = std::uint64_t;
+#elif PCP_VARIABLE_BITS == 32
+using Variable = std::uint32_t;
+#elif PCP_VARIABLE_BITS == 128
 using Variable = __uint128_t;
+#else
+#error "PCP_VARIABLE_BITS must be 32, 64 or 128"
+#endif
 // type used to represent constraint index
 using Index = size_t;
 
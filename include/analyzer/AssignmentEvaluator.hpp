@@ -0,0 +1,62 @@
+#ifndef ASSIGNMENTEVALUATOR_HPP
+#define ASSIGNMENTEVALUATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "constraint/BinaryConstraint.hpp"
+#include "pcp/BinaryCSP.hpp"
+#include "pcp/BinaryDomain.hpp"
+
+namespace analyzer {
+
+// The constraint list of a BinaryCSP as structure of arrays. Edge e joins u[e] and v[e] under the rule byte type[e],
+// the BINARY_CONSTRAINT_MASK bits of its constraint with NEGATED_BIT set when the constraint is negated.
+struct EdgeArrays {
+    static constexpr std::uint8_t NEGATED_BIT = 0x80;
+    // edges the vector path evaluates at once
+    static constexpr size_t BLOCK = 8;
+
+    EdgeArrays() = default;
+
+    explicit EdgeArrays(const pcp::BinaryCSP &pcp);
+
+    static std::uint8_t make_rule(constraint::BinaryConstraint c) {
+        size_t index = static_cast<size_t>(c);
+        return constraint::BINARY_CONSTRAINT_MASK[index] | (constraint::BINARY_CONSTRAINT_NEGATED[index] ? NEGATED_BIT : 0);
+    }
+
+    // whether packed values x and y satisfy rule
+    static int satisfied(std::uint8_t rule, std::uint8_t x, std::uint8_t y) {
+        return (((x ^ y) & rule & ~NEGATED_BIT) == 0) ^ (rule >> 7);
+    }
+
+    size_t size() const { return type.size(); }
+
+    // number of variables of the CSP, values passed to count_satisfied hold one byte for each
+    size_t variables = 0;
+    std::vector<pcp::Variable> u, v;
+    std::vector<std::uint8_t> type;
+    // gather_safe[b] is set when no edge of [b * BLOCK, (b + 1) * BLOCK) touches one of the last 3 variables, so the
+    // 4 byte gathers of the vector path stay inside values. Other blocks are evaluated one edge at a time.
+    std::vector<std::uint8_t> gather_safe;
+};
+
+// Number of edges in [first, last) satisfied by the packed values, on the calling thread. Uses AVX2 gathers when
+// built with AVX2. values holds edges.variables bytes.
+size_t count_satisfied(const EdgeArrays &edges, const std::uint8_t *values, size_t first, size_t last);
+
+// Number of edges satisfied by the packed values, split over a thread pool from EVALUATE_PARALLEL_THRESHOLD edges
+size_t count_satisfied(const EdgeArrays &edges, const std::uint8_t *values);
+
+// Fraction of the constraints of pcp satisfied when variable i takes assignment[i], 1 if there are no constraints.
+// Throws std::invalid_argument unless there is one value per variable.
+double evaluate_assignment(const pcp::BinaryCSP &pcp, const std::vector<pcp::BinaryDomain> &assignment);
+
+// Fraction of the constraints of pcp satisfied by the values its variables currently hold
+double evaluate_assignment(const pcp::BinaryCSP &pcp);
+
+}
+
+#endif
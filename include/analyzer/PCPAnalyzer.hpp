@@ -1,37 +1,90 @@
 #ifndef SOUNDNESSVERIFIER_HPP
 #define SOUNDNESSVERIFIER_HPP
 
+#include <cstddef>
 #include <random>
 #include <utility>
 #include <vector>
 
 #include "pcp/BinaryCSP.hpp"
+#include "util/philox.hpp"
 
 namespace analyzer {
 
 using Satisfiability = bool;
 
+// Confidence interval used to decide when a sample has been queried enough
+enum class IntervalMethod {
+    WILSON,
+    HOEFFDING
+};
+
+// Estimated acceptance probability of one sample
+struct AcceptanceEstimate {
+    double acceptance;
+    // confidence interval at level 1 - QUERY_CONFIDENCE_DELTA / k for k samples, so that the intervals of all samples
+    // hold together with probability at least 1 - QUERY_CONFIDENCE_DELTA
+    double lower;
+    double upper;
+    size_t queries;
+};
+
+// Estimates completeness and soundness by querying random constraints of every sample. The trials are split into
+// chunks of QUERY_CHUNK_SIZE that run on a thread pool; chunk c of sample i draws from
+// constants::random_stream(ANALYZER, i, c) and counts into its own slot, so the estimates do not depend on the
+// thread count.
 class PCPAnalyzer {
 public:
+    // Runs exactly num_trial queries on every sample
     PCPAnalyzer(const std::vector<std::pair<pcp::BinaryCSP, Satisfiability>> &samples, const int num_trial);
 
+    // Adaptive mode: queries every sample chunk by chunk and stops as soon as the confidence interval on its
+    // acceptance probability is at most interval_width wide, or after num_trial queries. The confidence level is
+    // split over every chunk boundary the interval may be checked at, so stopping early does not weaken it. Uses
+    // the same random streams as the fixed mode, so its queries are a prefix of the fixed mode's.
+    PCPAnalyzer(const std::vector<std::pair<pcp::BinaryCSP, Satisfiability>> &samples, const int num_trial,
+        double interval_width, IntervalMethod method = IntervalMethod::WILSON);
+
     double getSoundness();
 
     double getCompleteness();
 
     double getGap();
 
+    // Averages of the per-sample interval bounds over the unsatisfiable / satisfiable samples. Whenever every
+    // per-sample interval holds, the average of the true acceptance probabilities lies in it, so it holds at level
+    // 1 - QUERY_CONFIDENCE_DELTA
+    std::pair<double, double> getSoundnessInterval() const;
+
+    std::pair<double, double> getCompletenessInterval() const;
+
+    // Per-sample estimates, in the order of samples
+    const std::vector<AcceptanceEstimate>& getEstimates() const;
+
+    // Queries made over all samples
+    size_t getQueriesUsed() const;
+
 private:
+    void summarize();
+
     const std::vector<std::pair<pcp::BinaryCSP, Satisfiability>> &samples;
     const int num_trial;
     double soundness;
     double completeness;
     double gap;
+    std::pair<double, double> soundness_interval;
+    std::pair<double, double> completeness_interval;
+    std::vector<AcceptanceEstimate> estimates;
+    size_t queries_used;
 
 };
 
 bool query(const pcp::BinaryCSP &sample);
 
+// Query `count` uniformly random constraints of sample and return how many are satisfied. Constraint indices are
+// drawn QUERY_BATCH_SIZE at a time and then evaluated in one pass over the packed assignment.
+size_t query_batch(const pcp::BinaryCSP &sample, size_t count, util::philox &rng);
+
 }
 
 #endif
\ No newline at end of file
@@ -1,6 +1,11 @@
 #ifndef SOUNDNESSAPPROXIMATER_HPP
 #define SOUNDNESSAPPROXIMATER_HPP
 
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
 #include "pcp/BinaryCSP.hpp"
 #include "constants.hpp"
 
@@ -15,6 +20,29 @@ const double Tmin = 1e-4;
 const double alpha = 0.995;
 // iterations per temperature
 const size_t iter_per_temp_default = 100000;
+// temperature steps every chain runs between two plateau checks of multi-chain annealing
+const size_t steps_per_epoch = 8;
+// below this temperature annealing stops once no chain improved its best for plateau_steps temperature steps
+const double plateau_temperature = 0.05;
+const size_t plateau_steps = 64;
+
+// Replica exchange parameters
+// hottest and coldest temperature of the geometric ladder
+const double tempering_max_T = 1.0;
+const double tempering_min_T = 0.02;
+// number of replicas, one per temperature
+const size_t replicas_default = 8;
+// Metropolis moves every replica runs between two rounds of swap attempts
+const size_t moves_per_swap_default = 10000;
+// rounds of swap attempts
+const size_t swap_rounds_default = 1000;
+
+// Walk search parameters
+// steps before the walk gives up
+const size_t walk_flips_default = 20000000;
+// probability of a random move on the picked violated constraint instead of the greedy one
+const double walk_noise_default = 0.2;
+
 // Map from constraint type to possible values in its domain
 const std::map<three_csp::Constraint, std::vector<pcp::BinaryDomain>> possible_values = {
     {
@@ -65,7 +93,62 @@ const std::map<three_csp::Constraint, std::vector<pcp::BinaryDomain>> possible_v
     }
 };
 
-double approximate_soundness(pcp::BinaryCSP &pcp, size_t iter_per_temp = iter_per_temp_default); 
+// Outcome of a run of one of the engines below, to compare them with each other
+struct SearchReport {
+    // best fraction of satisfied constraints reached
+    double soundness = 1.0;
+    // moves that changed the assignment
+    size_t flips = 0;
+    double flips_per_second = 0;
+    // wall time of the run, and the time at which the best assignment was first reached, estimated from the number
+    // of moves made by then
+    double seconds = 0;
+    double seconds_to_best = 0;
+};
+
+// Anneals a single chain, same as approximate_soundness_multi_chain with one chain
+double approximate_soundness(pcp::BinaryCSP &pcp, size_t iter_per_temp = iter_per_temp_default, std::uint64_t stream = 0); 
+
+// Runs `chains` independent annealing chains on a thread pool, each on its own copy of the assignment, and returns
+// the best fraction of satisfied constraints any of them reached. The final assignment of the best chain is left in
+// pcp. Chain k draws from constants::random_stream(ANNEALER, k, stream) and the chains only synchronise between
+// epochs, so the result is the same for any number of threads. Stops early once every constraint is satisfied or
+// all chains plateau at low temperature.
+double approximate_soundness_multi_chain(pcp::BinaryCSP &pcp, size_t chains, size_t iter_per_temp = iter_per_temp_default,
+    std::uint64_t stream = 0, SearchReport *report = nullptr);
+
+// Result of replica exchange
+struct TemperingResult {
+    // best fraction of satisfied constraints reached by any replica
+    double soundness;
+    // best fraction reached after each round of swap attempts, for judging convergence
+    std::vector<double> trace;
+    // fraction of accepted swaps between temperature t and t + 1 of the ladder
+    std::vector<double> swap_acceptance;
+};
+
+// Replica exchange (parallel tempering): `replicas` chains run at fixed temperatures of a geometric ladder between
+// tempering_max_T and tempering_min_T, one chain per pool task, and after every `moves_per_swap` moves neighbouring
+// temperatures try to swap their assignments. The final assignment of the best replica is left in pcp. Random
+// choices come from constants::random_stream(REPLICA_EXCHANGE, ..., stream), so the result does not depend on the
+// thread count. Stops early once every constraint is satisfied.
+TemperingResult approximate_soundness_tempering(pcp::BinaryCSP &pcp, size_t replicas = replicas_default,
+    size_t swap_rounds = swap_rounds_default, size_t moves_per_swap = moves_per_swap_default, std::uint64_t stream = 0,
+    SearchReport *report = nullptr);
+
+// Focused local search in the style of WalkSAT: every step picks a random violated constraint from an incrementally
+// maintained violated set and changes one of its two variables, to a random value with probability `noise` and to
+// the value that satisfies the most constraints otherwise. Stops after max_flips steps or once every constraint is
+// satisfied. A step where neither variable can change counts against max_flips but not in report.flips. Draws from
+// constants::random_stream(WALK, 0, stream).
+// pcp is left with the final assignment of the walk, not the best one, so it can satisfy fewer constraints than
+// report.soundness.
+SearchReport approximate_soundness_walksat(pcp::BinaryCSP &pcp, size_t max_flips = walk_flips_default,
+    double noise = walk_noise_default, std::uint64_t stream = 0);
+
+// Runs the engine called `engine` with its default parameters: "anneal", "multi_chain" (one chain per hardware
+// thread), "tempering" or "walksat". Throws std::invalid_argument for any other name.
+SearchReport run_soundness_engine(const std::string &engine, pcp::BinaryCSP &pcp, std::uint64_t stream = 0);
 
 double approximate_soundness_via_random_subset(pcp::BinaryCSP &pcp);
 
@@ -4,10 +4,12 @@
 #include <random>
 #include <functional>
 #include <cmath>
+#include <cstdint>
 #include <map>
 #include <vector>
 
 #include "Aliases.hpp"
+#include "util/philox.hpp"
 
 namespace constants {
 
@@ -26,9 +28,26 @@ const int DEGREE = 5;
 #endif
 const int EXPANDING_COEFFICIENT = 1;
 const unsigned int SAFE_THREAD_NUMBER = 4;
+// number of consecutive variables a worker powers as one parallel_for chunk in gap amplification
+const size_t POWERING_CHUNK_SIZE = 8;
+// number of variables powered before their reduced PCPs are streamed into the output, a multiple of POWERING_CHUNK_SIZE
+const size_t POWERING_WINDOW_SIZE = 512;
+// number of edges a worker builds gadgets for as one parallel_for chunk in three_color_to_BinaryCSP
+const size_t GADGET_BUILD_CHUNK_SIZE = 16;
+// number of edges a worker copies gadgets for as one parallel_for chunk in three_color_to_BinaryCSP
+const size_t GADGET_STAMP_CHUNK_SIZE = 256;
 const pcp::Variable PCPVARIABLE_ONE = 1;
 const int QUERY_SAMPLING_REPETITION = 100;
 const int SUBSET_SIZE = 100;
+// number of constraint indices PCPAnalyzer draws before evaluating them in one pass
+const size_t QUERY_BATCH_SIZE = 256;
+// number of trials on one sample PCPAnalyzer runs as one parallel_for chunk
+const size_t QUERY_CHUNK_SIZE = 4096;
+// PCPAnalyzer's confidence intervals miss the true acceptance probability with at most this probability
+const double QUERY_CONFIDENCE_DELTA = 0.01;
+// number of constraints evaluate_assignment counts as one parallel_for chunk, and the size from which it uses threads
+const size_t EVALUATE_CHUNK_SIZE = 1 << 16;
+const size_t EVALUATE_PARALLEL_THRESHOLD = 1 << 20;
 
 const std::function<int(size_t)> DEFAULT_ITERATION_FUNC = [](size_t edge_size) {
     return static_cast<int>(std::ceil(std::log10(edge_size)));
@@ -37,6 +56,30 @@ const std::function<int(size_t)> DEFAULT_ITERATION_FUNC = [](size_t edge_size) {
 // Fixed random seed for reproducibility
 inline thread_local std::mt19937 RANDOM_SEED{453};
 
+// Seed of the counter-based streams below, shared by all threads; only change it between runs
+inline std::uint64_t GLOBAL_SEED = 453;
+
+// Stages of the reduction that draw from their own counter-based streams. The value selects the stream, so existing
+// stages keep their number and new stages are appended.
+enum class RandomStage : std::uint32_t {
+    EXPANDER = 0,
+    DEGREE_REDUCTION = 1,
+    TESTER = 2,
+    GADGET_TEMPLATE = 3,
+    EDGE_GADGET = 4,
+    ANNEALER = 5,
+    SUBSET_SAMPLING = 6,
+    REPLICA_EXCHANGE = 7,
+    WALK = 8,
+    ANALYZER = 9
+};
+
+// Generator for item `index` (variable, edge, chain...) of `stage` in round `round` of the reduction.
+// The numbers drawn depend on nothing else, so results are identical for any number of threads
+inline util::philox random_stream(RandomStage stage, std::uint64_t index, std::uint64_t round = 0) {
+    return util::philox(util::philox::derive_key(GLOBAL_SEED, round), static_cast<std::uint32_t>(stage), index);
+}
+
 }
 
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #ifndef BinaryConstraint_HPP
 #define BinaryConstraint_HPP
 
+#include <cstdint>
 #include <functional>
 
 #include "Aliases.hpp"
@@ -9,9 +10,30 @@
 
 namespace constraint {
 
+// Packed bits of pcp::BinaryDomain that each BinaryConstraint compares, indexed by the constraint
+inline constexpr std::uint8_t BINARY_CONSTRAINT_MASK[] = {
+    0x00, // ANY
+    0x3F, // EQUAL, value and domain type
+    0x3F, // NOTEQUAL, value and domain type
+    0x01, // FIRST_BIT_EQUAL
+    0x02, // SECOND_BIT_EQUAL
+    0x04, // THIRD_BIT_EQUAL
+};
+
+// Whether the constraint is satisfied when the masked bits differ rather than agree
+inline constexpr bool BINARY_CONSTRAINT_NEGATED[] = {
+    false, false, true, false, false, false,
+};
+
+// Branchless evaluation of a BinaryConstraint on two packed BinaryDomain bytes
+inline bool evaluatePackedBinaryConstraint(BinaryConstraint constraint, std::uint8_t x, std::uint8_t y) {
+    size_t index = static_cast<size_t>(constraint);
+    return (((x ^ y) & BINARY_CONSTRAINT_MASK[index]) == 0) != BINARY_CONSTRAINT_NEGATED[index];
+}
+
 // Evaluate the BinaryConstraint on two BinaryDomain values
 bool evaluateBinaryConstraint(BinaryConstraint constraint, pcp::BinaryDomain x, pcp::BinaryDomain y);
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,8 @@
 #ifndef CORE_HPP
 #define CORE_HPP
 
+#include <cstdint>
+
 #include "pcp/BinaryCSP.hpp"
 #include "constants.hpp"
 #include "pcpp/TesterFactory.hpp"
@@ -9,14 +11,17 @@
 
 namespace core {
 
+// Random choices below are drawn from constants::random_stream keyed by `round`, so repeated rounds of
+// three_color_gap_amplification get fresh randomness and a round's output does not depend on the thread count
+
 // to_expander turns a BinaryCSP into a BinaryCSP where the graph is an expander
-pcp::BinaryCSP& to_expander(pcp::BinaryCSP &pcp, int expanding_coefficient);
+pcp::BinaryCSP& to_expander(pcp::BinaryCSP &pcp, int expanding_coefficient, std::uint64_t round = 0);
 
 // reduce_degree reduces the degree of a BinaryCSP to degree by replacing each variable with a graph of variables
-pcp::BinaryCSP reduce_degree(const pcp::BinaryCSP &pcp, int degree);
+pcp::BinaryCSP reduce_degree(const pcp::BinaryCSP &pcp, int degree, std::uint64_t round = 0);
 
 // gap_amplification amplifies the gap of a BinaryCSP to constant
-pcp::BinaryCSP gap_amplification(pcp::BinaryCSP pcp, pcpp::TesterType tester_type);
+pcp::BinaryCSP gap_amplification(pcp::BinaryCSP pcp, pcpp::TesterType tester_type, std::uint64_t round = 0);
 
 // Converts a ThreeColor instance to a BinaryCSP instance
 pcp::BinaryCSP three_color_gap_amplification(const three_color::ThreeColor &tc, pcpp::TesterType tester_type, const std::function<int(size_t)>& iterations_func = constants::DEFAULT_ITERATION_FUNC);
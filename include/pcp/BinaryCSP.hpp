@@ -8,9 +8,14 @@
 #include "constraint/BinaryConstraint.hpp"
 #include "Aliases.hpp"
 #include "pcp/BinaryDomain.hpp"
+#include "pcp/Neighborhoods.hpp"
+#include "util/bfs_workspace.hpp"
+#include "util/span.hpp"
 
 namespace pcp {
 
+class FrozenBinaryCSP;
+
 class BinaryCSP {
 public:
     BinaryCSP();
@@ -32,6 +37,9 @@ public:
 
     BinaryDomain get_variable(Variable var) const;
 
+    // packed assignment of every variable, indexed by variable
+    const std::vector<BinaryDomain>& get_variables() const;
+
     void set_variable(Variable var, BinaryDomain value);
 
     void add_variable(BinaryDomain value);
@@ -44,14 +52,24 @@ public:
 
     void add_constraint(Variable var, Variable other_var, constraint::BinaryConstraint constraint);
 
-    // BFS to get all neighbors within a certain radius
+    // BFS to get all neighbors within a certain radius, using the calling thread's workspace
     std::vector<Variable> get_neighbors(Variable var, int radius) const;
 
+    std::vector<Variable> get_neighbors(Variable var, int radius, util::bfs_workspace &workspace) const;
+
+    // Balls of radius `radius` around every variable, or every variable in [first, last),
+    // stored back to back and each in get_neighbors order
+    Neighborhoods all_neighborhoods(int radius) const;
+
+    Neighborhoods all_neighborhoods(int radius, Variable first, Variable last) const;
+
     // Get a BinaryCSP consisting of the neighboring variables and constraints within a certain radius
     BinaryCSP get_neighboring_pcp(Variable var, int radius) const;
 
     // Build a sub-BinaryCSP from a list of variables
-    BinaryCSP build_sub_pcp(const std::vector<Variable> &neighbors) const;
+    BinaryCSP build_sub_pcp(util::span<Variable> neighbors) const;
+
+    BinaryCSP build_sub_pcp(util::span<Variable> neighbors, util::bfs_workspace &workspace) const;
 
     // getting rid of variables with no constraints running through it
     void clean();
@@ -60,6 +78,11 @@ public:
     friend std::ostream& operator<<(std::ostream &os, const BinaryCSP &BinaryCSP);
 
 private:
+    friend class FrozenBinaryCSP;
+
+    // bulk version of add_constraint that sizes every adjacency list up front
+    void add_constraints(const std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> &edges);
+
     size_t size;
     std::vector<BinaryDomain> variables;
     // adjacent list representation of constraints used for graph traversal
@@ -2,11 +2,14 @@
 #define BinaryDomain_HPP
 
 #include <bitset>
+#include <cstdint>
 
 #include "Aliases.hpp"
 
 namespace pcp {
 
+// A 3-bit value together with its domain type, packed into a single byte:
+// bits 0-2 hold the value and bits 3-5 hold the three_csp::Constraint domain type
 class BinaryDomain {
 public:
     BinaryDomain();
@@ -17,21 +20,35 @@ public:
 
     BinaryDomain(bool bit0, bool bit1, bool bit2, three_csp::Constraint domain_type);
 
-    bool operator==(const BinaryDomain &other) const;
+    bool operator==(const BinaryDomain &other) const { return packed == other.packed; }
 
-    bool operator!=(const BinaryDomain &other) const;
+    bool operator!=(const BinaryDomain &other) const { return packed != other.packed; }
 
-    bool operator[](size_t index) const;
+    bool operator[](size_t index) const { return (packed >> index) & 1; }
 
-    three_csp::Constraint get_domain_type() const;
+    three_csp::Constraint get_domain_type() const {
+        return static_cast<three_csp::Constraint>(packed >> VALUE_BITS);
+    }
 
     void set_domain_type(three_csp::Constraint new_domain_type);
 
+    // the three value bits as an integer in [0, 8)
+    int get_value() const { return packed & VALUE_MASK; }
+
+    // raw byte representation, equal bytes mean equal BinaryDomains
+    std::uint8_t get_packed() const { return packed; }
+
+    static BinaryDomain from_packed(std::uint8_t packed);
+
+    static constexpr int VALUE_BITS = static_cast<int>(BinaryDomainSize);
+    static constexpr std::uint8_t VALUE_MASK = (1 << VALUE_BITS) - 1;
+
 private:
-    std::bitset<3> bits;
-    three_csp::Constraint domain_type;
+    std::uint8_t packed;
 };
 
+static_assert(sizeof(BinaryDomain) == 1, "BinaryDomain must stay packed in a single byte");
+
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,138 @@
+#ifndef FrozenBinaryCSP_HPP
+#define FrozenBinaryCSP_HPP
+
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "constraint/BinaryConstraint.hpp"
+#include "Aliases.hpp"
+#include "pcp/BinaryCSP.hpp"
+#include "pcp/BinaryDomain.hpp"
+#include "pcp/Neighborhoods.hpp"
+#include "util/bfs_workspace.hpp"
+#include "util/span.hpp"
+
+namespace pcp {
+
+// View over the constraints incident to one variable, iterated as (neighbor, constraint) pairs
+class ConstraintView {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<Variable, constraint::BinaryConstraint>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        iterator(const Variable *neighbor, const constraint::BinaryConstraint *type)
+         : neighbor(neighbor), type(type) {}
+
+        value_type operator*() const { return {*neighbor, *type}; }
+
+        iterator& operator++() {
+            ++neighbor;
+            ++type;
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const { return neighbor == other.neighbor; }
+
+        bool operator!=(const iterator &other) const { return neighbor != other.neighbor; }
+
+    private:
+        const Variable *neighbor;
+        const constraint::BinaryConstraint *type;
+    };
+
+    ConstraintView(const Variable *neighbors, const constraint::BinaryConstraint *types, size_t count)
+     : neighbor_span(neighbors, count), type_span(types, count) {}
+
+    iterator begin() const { return iterator(neighbor_span.begin(), type_span.begin()); }
+
+    iterator end() const { return iterator(neighbor_span.end(), type_span.end()); }
+
+    size_t size() const { return neighbor_span.size(); }
+
+    bool empty() const { return neighbor_span.empty(); }
+
+    std::pair<Variable, constraint::BinaryConstraint> operator[](size_t index) const {
+        return {neighbor_span[index], type_span[index]};
+    }
+
+    util::span<Variable> neighbors() const { return neighbor_span; }
+
+    util::span<constraint::BinaryConstraint> constraints() const { return type_span; }
+
+private:
+    util::span<Variable> neighbor_span;
+    util::span<constraint::BinaryConstraint> type_span;
+};
+
+// Immutable compressed sparse row (CSR) form of a BinaryCSP.
+// The constraint graph is built once from the edge list and can not be changed afterwards,
+// only the assignment of the variables can be updated.
+class FrozenBinaryCSP {
+public:
+    FrozenBinaryCSP();
+
+    FrozenBinaryCSP(const BinaryCSP &pcp);
+
+    FrozenBinaryCSP(BinaryCSP &&pcp);
+
+    FrozenBinaryCSP(std::vector<BinaryDomain> &&variables,
+        std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> &&constraints_list);
+
+    // Member functions
+    size_t get_size() const;
+
+    BinaryDomain get_variable(Variable var) const;
+
+    void set_variable(Variable var, BinaryDomain value);
+
+    const std::vector<BinaryDomain>& get_variables() const;
+
+    // same neighbor order as BinaryCSP::get_constraints
+    ConstraintView get_constraints(Variable var) const;
+
+    const std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>>& get_constraints_list() const;
+
+    // BFS to get all neighbors within a certain radius, in the same order as BinaryCSP::get_neighbors
+    std::vector<Variable> get_neighbors(Variable var, int radius) const;
+
+    std::vector<Variable> get_neighbors(Variable var, int radius, util::bfs_workspace &workspace) const;
+
+    // Balls of radius `radius` around every variable, or every variable in [first, last),
+    // stored back to back and each in get_neighbors order
+    Neighborhoods all_neighborhoods(int radius) const;
+
+    Neighborhoods all_neighborhoods(int radius, Variable first, Variable last) const;
+
+    // Get a BinaryCSP consisting of the neighboring variables and constraints within a certain radius
+    BinaryCSP get_neighboring_pcp(Variable var, int radius) const;
+
+    // Build a sub-BinaryCSP from a list of variables
+    BinaryCSP build_sub_pcp(util::span<Variable> neighbors) const;
+
+    BinaryCSP build_sub_pcp(util::span<Variable> neighbors, util::bfs_workspace &workspace) const;
+
+    // Copy the assignment and the constraints back into a mutable BinaryCSP
+    BinaryCSP thaw() const;
+
+private:
+    void build_adjacency();
+
+    std::vector<BinaryDomain> variables;
+    // edge list representation of constraints, identical to BinaryCSP::get_constraints_list
+    std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> constraints_list;
+    // constraints of variable i live in [offsets[i], offsets[i + 1]) of neighbors and constraint_types
+    std::vector<Index> offsets;
+    std::vector<Variable> neighbors;
+    std::vector<constraint::BinaryConstraint> constraint_types;
+};
+
+}
+
+#endif
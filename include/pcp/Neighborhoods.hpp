@@ -0,0 +1,73 @@
+#ifndef NEIGHBORHOODS_HPP
+#define NEIGHBORHOODS_HPP
+
+#include <stdexcept>
+#include <vector>
+
+#include "Aliases.hpp"
+#include "util/bfs_workspace.hpp"
+#include "util/span.hpp"
+
+namespace pcp {
+
+// The radius-r balls of a consecutive range of source variables, stored back to back.
+// The ball of source u lives in [offsets[u - first], offsets[u - first + 1]) of indices
+// and lists its variables in the same BFS order as get_neighbors(u, r).
+class Neighborhoods {
+public:
+    Neighborhoods() : first(0), offsets(1, 0) {}
+
+    Neighborhoods(Variable first, std::vector<Index> &&offsets, std::vector<Variable> &&indices)
+     : first(first), offsets(std::move(offsets)), indices(std::move(indices)) {}
+
+    // number of balls
+    size_t size() const { return offsets.size() - 1; }
+
+    // source of the first ball
+    Variable get_first() const { return first; }
+
+    // ball around source variable u
+    util::span<Variable> get_ball(Variable u) const {
+        if (u < first || u - first >= static_cast<Variable>(size())) {
+            throw std::out_of_range("Neighborhoods::get_ball: source out of range");
+        }
+        size_t i = static_cast<size_t>(u - first);
+        return util::span<Variable>(indices.data() + offsets[i], indices.data() + offsets[i + 1]);
+    }
+
+    const std::vector<Index>& get_offsets() const { return offsets; }
+
+    const std::vector<Variable>& get_indices() const { return indices; }
+
+private:
+    Variable first;
+    std::vector<Index> offsets;
+    std::vector<Variable> indices;
+};
+
+// Compute the balls of every source in [first, last) into one Neighborhoods.
+// Each ball is written straight behind the previous one and its slot doubles as the BFS queue,
+// so no per-ball vectors are allocated.
+// Graph must provide get_size() and get_constraints(v) iterating (neighbor, constraint) pairs.
+template <typename Graph>
+Neighborhoods collect_neighborhoods(const Graph &graph, int radius, Variable first, Variable last,
+    util::bfs_workspace &workspace) {
+    if (first > last || last > static_cast<Variable>(graph.get_size())) {
+        throw std::out_of_range("collect_neighborhoods: source range out of range");
+    }
+    size_t count = static_cast<size_t>(last - first);
+    std::vector<Index> offsets;
+    offsets.reserve(count + 1);
+    offsets.push_back(0);
+    std::vector<Variable> indices;
+    for (Variable u = first; u < last; ++u) {
+        workspace.append_ball(graph, u, radius, indices);
+        // no reserve from the first ball: ball sizes vary widely around hubs, so the buffer grows geometrically
+        offsets.push_back(indices.size());
+    }
+    return Neighborhoods(first, std::move(offsets), std::move(indices));
+}
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef CONSTRAINTMATRIX_HPP
+#define CONSTRAINTMATRIX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "pcpp/HadamardPCPP/Position.hpp"
+#include "util/span.hpp"
+
+namespace pcpp {
+
+// Rows of a GF(2) constraint matrix stored as sparse column lists: row r sets the columns
+// columns[offsets[r], offsets[r + 1]), in increasing order.
+// Hadamard tester rows set 2 to 8 bits out of thousands, so XORing a row into a position costs
+// its nonzeros instead of its width; dense_row() gives the packed Position form of a row.
+class ConstraintMatrix {
+public:
+    ConstraintMatrix() : width(0), offsets(1, 0) {}
+
+    explicit ConstraintMatrix(size_t width) : width(width), offsets(1, 0) {}
+
+    size_t get_width() const { return width; }
+
+    size_t get_row_count() const { return offsets.size() - 1; }
+
+    // Append a row setting the given columns, a column listed more than once is set once
+    void add_row(std::vector<size_t> row) {
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        if (!row.empty() && row.back() >= width) {
+            throw std::out_of_range("ConstraintMatrix::add_row: column out of range");
+        }
+        columns.insert(columns.end(), row.begin(), row.end());
+        offsets.push_back(columns.size());
+    }
+
+    // Append the set bits of a dense row
+    void add_row(const Position &row) {
+        if (row.size() != width) {
+            throw std::out_of_range("ConstraintMatrix::add_row: row width mismatch");
+        }
+        const std::vector<Position::Word> &words = row.get_words();
+        for (size_t w = 0; w < words.size(); ++w) {
+            for (Position::Word word = words[w]; word != 0; word &= word - 1) {
+                columns.push_back(w * Position::WORD_BITS + __builtin_ctzll(word));
+            }
+        }
+        offsets.push_back(columns.size());
+    }
+
+    util::span<size_t> get_row(size_t r) const {
+        return util::span<size_t>(columns.data() + offsets[r], columns.data() + offsets[r + 1]);
+    }
+
+    // position ^= row r, position must be at least as wide as the matrix
+    void add_to(size_t r, Position &position) const {
+        for (size_t i = offsets[r]; i < offsets[r + 1]; ++i) {
+            position.flip(columns[i]);
+        }
+    }
+
+    Position dense_row(size_t r) const {
+        Position row(width);
+        add_to(r, row);
+        return row;
+    }
+
+private:
+    size_t width;
+    std::vector<size_t> offsets;
+    std::vector<size_t> columns;
+};
+
+}
+
+#endif
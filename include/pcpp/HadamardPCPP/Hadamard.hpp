@@ -1,10 +1,10 @@
-
 #ifndef HADAMARD_HPP
 #define HADAMARD_HPP
 
 #include <vector>
 
 #include "Aliases.hpp"
+#include "pcpp/HadamardPCPP/Position.hpp"
 
 namespace pcpp {
 
@@ -14,14 +14,23 @@ public:
 
     Hadamard(const std::vector<bool> value);
 
+    // Inner product of the encoded value and idx over GF(2), a word at a time
+    bool query(const Position &idx) const;
+
     bool query(const std::vector<bool>& idx) const;
 
     bool query(std::vector<bool>&& idx) const;
 
+    // Whole codeword, entry i is the query at the bits of i. Positions are visited in Gray code
+    // order so each step flips one bit of the index and updates the parity in O(1)
     std::vector<bool> getCode() const;
 
+    // Whole codeword packed 64 entries per word. The low 6 index bits give one fixed word pattern
+    // and every higher bit doubles the code by appending a copy XORed with all ones or nothing
+    Position getPackedCode() const;
+
 private:
-    std::vector<bool> value;
+    Position value;
 };
 
 }
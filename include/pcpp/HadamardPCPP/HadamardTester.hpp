@@ -14,10 +14,13 @@
 
 #include "pcp/BinaryCSP.hpp"
 #include "constraint/BinaryConstraint.hpp"
+#include "pcpp/HadamardPCPP/ConstraintMatrix.hpp"
 #include "pcpp/HadamardPCPP/Hadamard.hpp"
+#include "pcpp/HadamardPCPP/Position.hpp"
 #include "pcpp/Tester.hpp"
 #include "three_color/ThreeColor.hpp"
 #include "three_csp/ThreeCSP.hpp"
+#include "util/philox.hpp"
 
 namespace pcpp {
 
@@ -31,22 +34,39 @@ public:
     HadamardTester(const pcp::BinaryCSP &powering_pcp);
 
     pcp::BinaryCSP three_color_to_BinaryCSP(const three_color::ThreeColor &tc) override; 
+
+    // With k > 0, three_color_to_BinaryCSP builds k randomized gadgets per ordered color pair once and
+    // copies a randomly chosen one for every edge instead of running a fresh tester per edge.
+    // 0, the default, builds every edge's gadget independently
+    void set_gadget_templates(size_t templates_per_pair);
     
     void create_tester(const pcp::BinaryCSP &powering_pcp) override;
 
     // Build a BinaryCSP from the constraint matrix and hadamard code
     pcp::BinaryCSP buildBinaryCSP() override;
 
+    pcp::BinaryCSP buildBinaryCSP(util::philox &rng) override;
+
     pcp::BinaryCSP buildBinaryCSP(
         int constraint_combination_repetition,
         int consistency_test_repetition,
         int linearity_test_repetition
     );
 
+    // Same as above, drawing every random choice from rng instead of the thread's RANDOM_SEED
+    pcp::BinaryCSP buildBinaryCSP(
+        int constraint_combination_repetition,
+        int consistency_test_repetition,
+        int linearity_test_repetition,
+        util::philox &rng
+    );
+
 private:
+    size_t gadget_templates = 0;
     three_csp::ThreeCSP three_csp;
     Hadamard hadamard;
-    std::vector<std::vector<bool>> constraint_matrix;
+    // one sparse row per constraint, selecting the bits whose parity the constraint fixes
+    ConstraintMatrix constraint_matrix;
     // Expected parity (in GF(2)) for each constraint row under the canonical assignment
     std::vector<bool> constraint_parities;
     std::unordered_map<size_t, size_t> binary_index_shift;
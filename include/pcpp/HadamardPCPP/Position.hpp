@@ -0,0 +1,84 @@
+#ifndef POSITION_HPP
+#define POSITION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace pcpp {
+
+// Bit vector packed 64 bits per word, used for Hadamard query positions and constraint rows.
+// Bit i lives in bit i % 64 of word i / 64 and the unused bits of the last word stay zero,
+// so positions are XORed, compared and hashed a whole word at a time.
+class Position {
+public:
+    using Word = std::uint64_t;
+    static constexpr size_t WORD_BITS = 64;
+
+    Position() : bits(0) {}
+
+    explicit Position(size_t size) : bits(size), words((size + WORD_BITS - 1) / WORD_BITS, 0) {}
+
+    // Adopt packed words, the bits past size in the last word must be zero
+    Position(size_t size, std::vector<Word> words) : bits(size), words(std::move(words)) {}
+
+    explicit Position(const std::vector<bool> &values) : Position(values.size()) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (values[i]) set(i, true);
+        }
+    }
+
+    size_t size() const { return bits; }
+
+    bool get(size_t i) const { return (words[i / WORD_BITS] >> (i % WORD_BITS)) & 1; }
+
+    void set(size_t i, bool value) {
+        Word mask = Word(1) << (i % WORD_BITS);
+        if (value) {
+            words[i / WORD_BITS] |= mask;
+        } else {
+            words[i / WORD_BITS] &= ~mask;
+        }
+    }
+
+    void flip(size_t i) { words[i / WORD_BITS] ^= Word(1) << (i % WORD_BITS); }
+
+    // Positions must have the same size
+    Position& operator^=(const Position &other) {
+        for (size_t w = 0; w < words.size(); ++w) {
+            words[w] ^= other.words[w];
+        }
+        return *this;
+    }
+
+    bool operator==(const Position &other) const { return bits == other.bits && words == other.words; }
+
+    bool operator!=(const Position &other) const { return !(*this == other); }
+
+    const std::vector<Word>& get_words() const { return words; }
+
+    size_t hash() const {
+        Word h = 0x9e3779b97f4a7c15ull ^ bits;
+        for (Word w : words) {
+            // splitmix64 finalizer over the running state
+            h ^= w;
+            h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+            h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+            h ^= h >> 31;
+        }
+        return static_cast<size_t>(h);
+    }
+
+private:
+    size_t bits;
+    std::vector<Word> words;
+};
+
+struct PositionHash {
+    size_t operator()(const Position &position) const { return position.hash(); }
+};
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "pcp/BinaryCSP.hpp"
 #include "three_color/ThreeColor.hpp" 
+#include "util/philox.hpp"
 
 namespace pcpp {
 
@@ -14,6 +15,9 @@ public:
 
     virtual pcp::BinaryCSP buildBinaryCSP() = 0;
 
+    // Same as buildBinaryCSP(), drawing every random choice from rng; testers without random choices ignore it
+    virtual pcp::BinaryCSP buildBinaryCSP(util::philox &/*rng*/) { return buildBinaryCSP(); }
+
     virtual ~Tester() = default;
 
 };
@@ -0,0 +1,101 @@
+#ifndef BFS_WORKSPACE_HPP
+#define BFS_WORKSPACE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Aliases.hpp"
+
+namespace util {
+
+// Reusable scratch space for breadth first searches over dense variable indices.
+// Visited marks are stamped with an epoch, so starting a new search is O(1) instead of
+// clearing or hashing, and the BFS output vector doubles as the queue.
+// The same stamps back a dense global-to-local remap table for building sub-CSPs.
+// A workspace is not thread safe, every thread owns its own (see local()).
+class bfs_workspace {
+public:
+    static constexpr pcp::Variable NOT_MAPPED = std::numeric_limits<pcp::Variable>::max();
+
+    // Begin a new traversal over indices in [0, size), invalidating all previous marks
+    void start(size_t size) {
+        if (stamps.size() < size) {
+            stamps.resize(size, 0);
+            local_index.resize(size);
+        }
+        if (++epoch == 0) {
+            // the counter wrapped around, old stamps could alias the new epoch
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    // Mark x as visited, returns false if it was already visited in this traversal
+    bool visit(size_t x) {
+        if (stamps[x] == epoch) return false;
+        stamps[x] = epoch;
+        return true;
+    }
+
+    bool visited(size_t x) const { return stamps[x] == epoch; }
+
+    // Mark x as visited and remember its local index for this traversal
+    void map(size_t x, pcp::Variable local) {
+        stamps[x] = epoch;
+        local_index[x] = local;
+    }
+
+    // Local index given to x by map(), NOT_MAPPED if x was not mapped in this traversal
+    pcp::Variable lookup(size_t x) const {
+        return stamps[x] == epoch ? local_index[x] : NOT_MAPPED;
+    }
+
+    // Collect every variable within `radius` of `source` into `order`, in BFS order.
+    // Graph must provide get_size() and get_constraints(v) iterating (neighbor, constraint) pairs.
+    template <typename Graph>
+    void collect_ball(const Graph &graph, pcp::Variable source, int radius, std::vector<pcp::Variable> &order) {
+        order.clear();
+        append_ball(graph, source, radius, order);
+    }
+
+    // Same as collect_ball, but the ball is appended after the current contents of `order`
+    template <typename Graph>
+    void append_ball(const Graph &graph, pcp::Variable source, int radius, std::vector<pcp::Variable> &order) {
+        start(graph.get_size());
+        size_t begin = order.size();
+        order.push_back(source);
+        visit(source);
+
+        int depth = 0;
+        size_t layer_end = begin + 1; // order[layer_end] is the first variable one layer deeper
+        for (size_t head = begin; head < order.size(); ++head) {
+            if (head == layer_end) {
+                ++depth;
+                layer_end = order.size();
+            }
+            if (depth >= radius) break;
+            for (const auto &[neighbor, _] : graph.get_constraints(order[head])) {
+                if (visit(neighbor)) {
+                    order.push_back(neighbor);
+                }
+            }
+        }
+    }
+
+    // Workspace owned by the calling thread
+    static bfs_workspace& local() {
+        thread_local bfs_workspace workspace;
+        return workspace;
+    }
+
+private:
+    std::vector<std::uint32_t> stamps;
+    std::vector<pcp::Variable> local_index;
+    std::uint32_t epoch = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef CONCURRENT_DISJOINT_SET_UNION_HPP
+#define CONCURRENT_DISJOINT_SET_UNION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace util {
+
+// Lock-free union-find that many threads can merge into at once.
+// find() halves the path with CAS and merge() links the larger root below the smaller one, so every set is
+// rooted at its smallest element whatever order the merges race in.
+// find, merge and same_set are thread safe; grow and reserve must not overlap any other call.
+class concurrent_disjoint_set_union {
+public:
+    explicit concurrent_disjoint_set_union(size_t size = 0) { grow(size); }
+
+    concurrent_disjoint_set_union(const concurrent_disjoint_set_union &) = delete;
+    concurrent_disjoint_set_union& operator=(const concurrent_disjoint_set_union &) = delete;
+
+    concurrent_disjoint_set_union(concurrent_disjoint_set_union &&other) noexcept
+     : parent(std::move(other.parent)),
+       count(std::exchange(other.count, 0)),
+       capacity(std::exchange(other.capacity, 0)) {}
+
+    concurrent_disjoint_set_union& operator=(concurrent_disjoint_set_union &&other) noexcept {
+        parent = std::move(other.parent);
+        count = std::exchange(other.count, 0);
+        capacity = std::exchange(other.capacity, 0);
+        return *this;
+    }
+
+    size_t size() const { return count; }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity <= capacity) return;
+        std::unique_ptr<std::atomic<size_t>[]> new_parent(new std::atomic<size_t>[new_capacity]);
+        for (size_t i = 0; i < count; ++i) {
+            new_parent[i].store(parent[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        parent = std::move(new_parent);
+        capacity = new_capacity;
+    }
+
+    // Append singleton sets until the structure holds new_size elements
+    void grow(size_t new_size) {
+        if (new_size <= count) return;
+        if (new_size > capacity) {
+            reserve(std::max(new_size, capacity * 2));
+        }
+        for (size_t i = count; i < new_size; ++i) {
+            parent[i].store(i, std::memory_order_relaxed);
+        }
+        count = new_size;
+    }
+
+    size_t find(size_t x) {
+        while (true) {
+            size_t up = parent[x].load(std::memory_order_acquire);
+            if (up == x) return x;
+            size_t grandparent = parent[up].load(std::memory_order_acquire);
+            if (up != grandparent) {
+                // losing this race only means another thread already shortened the path
+                parent[x].compare_exchange_weak(up, grandparent, std::memory_order_release, std::memory_order_relaxed);
+            }
+            x = grandparent;
+        }
+    }
+
+    bool merge(size_t x, size_t y) {
+        while (true) {
+            x = find(x);
+            y = find(y);
+            if (x == y) return false;
+            if (x < y) std::swap(x, y);
+            // x must still be a root when it is hung below y, otherwise look the roots up again
+            size_t expected = x;
+            if (parent[x].compare_exchange_strong(expected, y, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return true;
+            }
+        }
+    }
+
+    bool same_set(size_t x, size_t y) {
+        while (true) {
+            x = find(x);
+            y = find(y);
+            if (x == y) return true;
+            // a root that is still a root after both lookups proves the sets were disjoint at that moment
+            if (parent[x].load(std::memory_order_acquire) == x) return false;
+        }
+    }
+
+private:
+    std::unique_ptr<std::atomic<size_t>[]> parent;
+    size_t count = 0;
+    size_t capacity = 0;
+};
+
+}
+
+#endif
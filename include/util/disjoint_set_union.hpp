@@ -2,25 +2,49 @@
 #define DISJOINT_SET_UNION_HPP
 
 #include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 namespace util {
 
+// Union-find with union by rank and iterative path compression.
+// Every element takes one 32-bit word: the parent index, or the rank of the set tagged with ROOT for a root,
+// so at most MAX_SIZE elements are supported.
 class disjoint_set_union {
 public:
+    static constexpr size_t MAX_SIZE = 0x7fffffff;
+
     disjoint_set_union(size_t size);
 
+    size_t get_size() const;
+
+    // number of disjoint sets
+    size_t get_set_count() const;
+
     size_t find(size_t x);
 
     bool merge(size_t x, size_t y);
 
     bool same_set(size_t x, size_t y);
 
+    // Append singleton sets until the structure holds new_size elements
+    void grow(size_t new_size);
+
+    // Merge every pair, returns how many of them joined two different sets
+    size_t merge_all(const std::vector<std::pair<size_t, size_t>> &pairs);
+
+    // Dense label in [0, get_set_count()) of the set of every element, sets numbered in order of their smallest element
+    std::vector<std::uint32_t> compress_all();
+
 private:
+    static constexpr std::uint32_t ROOT = 0x80000000u;
+
     size_t size;
-    std::vector<size_t> representative;
+    size_t set_count;
+    std::vector<std::uint32_t> node;
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,77 @@
+#ifndef PHILOX_HPP
+#define PHILOX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace util {
+
+// Philox4x32-10 counter-based generator (Salmon, Moraes, Dror, Shaw, SC 2011).
+// Output block n of a stream is a keyed bijection of the counter (n, stream, index), so every
+// (stream, index) pair is an independent sequence that any thread can start from scratch: no state
+// is shared between threads and the numbers drawn never depend on scheduling.
+// Satisfies UniformRandomBitGenerator, so it plugs into the <random> distributions.
+class philox {
+public:
+    using result_type = std::uint32_t;
+
+    philox(std::uint64_t key, std::uint32_t stream, std::uint64_t index)
+     : key{static_cast<std::uint32_t>(key), static_cast<std::uint32_t>(key >> 32)},
+       counter{0, stream, static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32)},
+       next(4) {}
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        if (next == 4) {
+            generate_block(counter, key, block);
+            ++counter[0];
+            next = 0;
+        }
+        return block[next++];
+    }
+
+    // Philox4x32-10 applied to one counter, for known answer tests
+    static void generate_block(const std::uint32_t (&counter)[4], const std::uint32_t (&key)[2], std::uint32_t (&out)[4]) {
+        std::uint32_t x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3];
+        std::uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                k0 += 0x9e3779b9u;
+                k1 += 0xbb67ae85u;
+            }
+            std::uint64_t p0 = static_cast<std::uint64_t>(0xd2511f53u) * x0;
+            std::uint64_t p1 = static_cast<std::uint64_t>(0xcd9e8d57u) * x2;
+            x0 = static_cast<std::uint32_t>(p1 >> 32) ^ x1 ^ k0;
+            x1 = static_cast<std::uint32_t>(p1);
+            x2 = static_cast<std::uint32_t>(p0 >> 32) ^ x3 ^ k1;
+            x3 = static_cast<std::uint32_t>(p0);
+        }
+        out[0] = x0;
+        out[1] = x1;
+        out[2] = x2;
+        out[3] = x3;
+    }
+
+    // Key for round `round` of a computation seeded by `seed`, scrambled by splitmix64 so that
+    // consecutive rounds do not use related keys
+    static std::uint64_t derive_key(std::uint64_t seed, std::uint64_t round) {
+        std::uint64_t z = seed + (round + 1) * 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    std::uint32_t key[2];
+    std::uint32_t counter[4];
+    std::uint32_t block[4];
+    size_t next;
+};
+
+}
+
+#endif
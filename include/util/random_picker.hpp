@@ -6,13 +6,16 @@
 #include <vector>
 #include <stdexcept>
 #include "constants.hpp"
+#include "util/philox.hpp"
 
 namespace util {
 
 template <typename T>
 class random_picker {
 public:
-    random_picker() : rng(constants::RANDOM_SEED) {}
+    random_picker() : rng(constants::RANDOM_SEED(), 0, 0) {}
+
+    explicit random_picker(util::philox rng) : rng(rng) {}
 
     void add(const T &item, int count) {
         if (count <= 0) return;
@@ -50,7 +53,7 @@ public:
         return items.size();
     }
 private:
-    std::mt19937 rng;
+    util::philox rng;
     std::unordered_map<T, size_t> counts;
     std::vector<T> items;
 };
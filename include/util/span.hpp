@@ -0,0 +1,51 @@
+#ifndef SPAN_HPP
+#define SPAN_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace util {
+
+// non-owning view over a contiguous range of elements, a minimal stand-in for C++20 std::span
+template <typename T>
+class span {
+public:
+    using value_type = T;
+    using iterator = const T *;
+
+    span() : first(nullptr), count(0) {}
+
+    span(const T *first, size_t count) : first(first), count(count) {}
+
+    span(const T *first, const T *last) : first(first), count(last - first) {}
+
+    span(const std::vector<T> &vec) : first(vec.data()), count(vec.size()) {}
+
+    iterator begin() const { return first; }
+
+    iterator end() const { return first + count; }
+
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    const T& operator[](size_t index) const { return first[index]; }
+
+    const T& at(size_t index) const {
+        if (index >= count) {
+            throw std::out_of_range("span::at: index out of range");
+        }
+        return first[index];
+    }
+
+    const T* data() const { return first; }
+
+private:
+    const T *first;
+    size_t count;
+};
+
+}
+
+#endif
@@ -1,12 +1,17 @@
 #ifndef THREAD_POOL_HPP
 #define THREAD_POOL_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -14,6 +19,116 @@
 
 namespace util {
 
+namespace detail {
+
+// Unit of work scheduled by thread_pool. Jobs are intrusive: whoever creates a job owns its
+// storage, the pool only moves pointers around, so scheduling itself never allocates.
+struct pool_job {
+    void (*execute)(pool_job *);
+};
+
+// Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+// The owning worker pushes and takes at the bottom, other threads steal from the top.
+class work_stealing_deque {
+public:
+    explicit work_stealing_deque(size_t capacity = 256) {
+        buffers.push_back(std::make_unique<ring>(capacity));
+        buffer.store(buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(pool_job *job) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        ring *a = buffer.load(std::memory_order_relaxed);
+        if (b - t > static_cast<std::int64_t>(a->capacity) - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, job);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only, newest job first
+    pool_job* take() {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        ring *a = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        pool_job *job = a->get(b);
+        if (t == b) {
+            // last job, race against thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // any thread, oldest job first; nullptr if empty or if another thread won the race
+    pool_job* steal() {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        ring *a = buffer.load(std::memory_order_acquire);
+        pool_job *job = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return job;
+    }
+
+    bool empty() const {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return bottom.load(std::memory_order_acquire) <= t;
+    }
+
+private:
+    struct ring {
+        explicit ring(size_t capacity) : capacity(capacity), mask(capacity - 1), slots(new std::atomic<pool_job *>[capacity]) {}
+
+        // release / acquire on the slot itself publishes the job's fields to whoever takes it
+        pool_job* get(std::int64_t i) const { return slots[i & mask].load(std::memory_order_acquire); }
+
+        void put(std::int64_t i, pool_job *job) { slots[i & mask].store(job, std::memory_order_release); }
+
+        size_t capacity; // always a power of two
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<pool_job *>[]> slots;
+    };
+
+    ring* grow(ring *old, std::int64_t t, std::int64_t b) {
+        buffers.push_back(std::make_unique<ring>(old->capacity * 2));
+        ring *a = buffers.back().get();
+        for (std::int64_t i = t; i < b; ++i) {
+            a->put(i, old->get(i));
+        }
+        // thieves may still read the old ring, so it is only released with the deque
+        buffer.store(a, std::memory_order_release);
+        return a;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top{0};
+    alignas(64) std::atomic<std::int64_t> bottom{0};
+    std::atomic<ring *> buffer{nullptr};
+    std::vector<std::unique_ptr<ring>> buffers; // touched by the owner only
+};
+
+}
+
+// Work-stealing thread pool. Every worker owns a Chase-Lev deque, tasks submitted from a worker go to
+// its own deque and idle workers steal from the others; tasks submitted from outside the pool go
+// through a shared injection queue.
 class thread_pool {
 public:
     explicit thread_pool(size_t thread_count) {
@@ -22,70 +137,332 @@ public:
         }
 
         workers.reserve(thread_count);
-
         for (size_t i = 0; i < thread_count; ++i) {
-            workers.emplace_back([this]() -> void {
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex);
-                        condition.wait(lock, [this]() -> bool {
-                            return stop || !tasks.empty();
-                        });
-                        
-                        if (stop && tasks.empty()) {
-                            return;
-                        }
-
-                        task = std::move(tasks.front());
-                        tasks.pop();
-                    }
-                    task();
-                }
+            workers.push_back(std::make_unique<worker>());
+        }
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers[i]->thread = std::thread([this, i]() -> void {
+                worker_loop(i);
             });
         }
     }
 
+    thread_pool(const thread_pool &) = delete;
+
+    thread_pool& operator=(const thread_pool &) = delete;
+
+    // Runs every task that was submitted before the pool is destroyed
     ~thread_pool() {
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for (std::thread &worker : workers) {
-            if (worker.joinable()) {
-                worker.join();
+        stop.store(true, std::memory_order_seq_cst);
+        wake(true);
+        for (const auto &w : workers) {
+            if (w->thread.joinable()) {
+                w->thread.join();
             }
         }
     }
 
+    size_t size() const { return workers.size(); }
+
     template <typename Function, typename... Args>
     auto enqueue(Function &&function, Args &&...args)
         -> std::future<std::invoke_result_t<Function, Args...>> {
         using result_type = std::invoke_result_t<Function, Args...>;
-        
-        auto task = std::make_shared<std::packaged_task<result_type()>>(
+
+        auto *job = new enqueued_job<result_type>(
             std::bind(std::forward<Function>(function), std::forward<Args>(args)...)
         );
+        std::future<result_type> future = job->task.get_future();
+        submit(job);
 
-        std::future<result_type> future = task->get_future();
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex);
-            tasks.emplace([task]() -> void { (*task)(); });
+        return future;
+    }
+
+    // Calls body(first, last) on consecutive chunks of at most `grain` indices covering [begin, end)
+    // and returns once every chunk is done. The range is split recursively, so idle workers steal
+    // large halves instead of single chunks; the calling thread works on the range as well.
+    // The first exception thrown by body is rethrown here after all chunks finished.
+    template <typename Body>
+    void parallel_for(size_t begin, size_t end, size_t grain, Body &&body) {
+        if (begin >= end) {
+            return;
+        }
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (end - begin + grain - 1) / grain;
+        if (chunks == 1) {
+            body(begin, end);
+            return;
         }
-        condition.notify_one();
 
-        return future;
+        range_state<std::remove_reference_t<Body>> state(*this, body, begin, end, grain, chunks);
+        state.run(0, chunks);
+        wait_for(state);
+        if (state.error) {
+            std::rethrow_exception(state.error);
+        }
     }
 
 private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop = false;
+    struct alignas(64) worker {
+        detail::work_stealing_deque jobs;
+        std::thread thread;
+    };
+
+    template <typename Result>
+    struct enqueued_job : detail::pool_job {
+        template <typename Function>
+        explicit enqueued_job(Function &&function)
+         : detail::pool_job{&enqueued_job::run}, task(std::forward<Function>(function)) {}
+
+        static void run(detail::pool_job *job) {
+            auto *self = static_cast<enqueued_job *>(job);
+            self->task();
+            delete self;
+        }
+
+        std::packaged_task<Result()> task;
+    };
+
+    // Shared bookkeeping of one parallel_for call, lives on the caller's stack
+    struct range_state_base {
+        std::atomic<size_t> pending;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+
+        explicit range_state_base(size_t chunks) : pending(chunks) {}
+
+        void complete_chunk() {
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done = true;
+                // the waiter can not leave before this lock is released, so notifying here is safe
+                finished.notify_all();
+            }
+        }
+    };
+
+    template <typename Body>
+    struct range_state : range_state_base {
+        // stolen right halves, slot i holds the job for the half starting at chunk i
+        struct range_job : detail::pool_job {
+            range_state *state;
+            size_t first_chunk;
+            size_t last_chunk;
+        };
+
+        range_state(thread_pool &pool, Body &body, size_t begin, size_t end, size_t grain, size_t chunks)
+         : range_state_base(chunks), pool(pool), body(body), begin(begin), end(end), grain(grain), jobs(chunks) {}
+
+        static void execute(detail::pool_job *job) {
+            auto *self = static_cast<range_job *>(job);
+            self->state->run(self->first_chunk, self->last_chunk);
+        }
+
+        void run(size_t first_chunk, size_t last_chunk) {
+            // publish the right half until a single chunk is left
+            while (last_chunk - first_chunk > 1) {
+                size_t mid = first_chunk + (last_chunk - first_chunk) / 2;
+                jobs[mid].execute = &range_state::execute;
+                jobs[mid].state = this;
+                jobs[mid].first_chunk = mid;
+                jobs[mid].last_chunk = last_chunk;
+                pool.submit(&jobs[mid]);
+                last_chunk = mid;
+            }
+            size_t first = begin + first_chunk * grain;
+            size_t last = std::min(end, first + grain);
+            try {
+                body(first, last);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            complete_chunk();
+        }
+
+        thread_pool &pool;
+        Body &body;
+        size_t begin;
+        size_t end;
+        size_t grain;
+        std::vector<range_job> jobs;
+    };
+
+    // which pool, if any, the calling thread is a worker of
+    struct worker_context {
+        thread_pool *pool = nullptr;
+        size_t index = 0;
+    };
+
+    static worker_context& context() {
+        thread_local worker_context current;
+        return current;
+    }
+
+    bool is_own_worker() const { return context().pool == this; }
+
+    void submit(detail::pool_job *job) {
+        if (is_own_worker()) {
+            workers[context().index]->jobs.push(job);
+        } else {
+            std::lock_guard<std::mutex> lock(injection_mutex);
+            injected.push_back(job);
+            injected_count.fetch_add(1, std::memory_order_seq_cst);
+        }
+        wake(false);
+    }
+
+    // Pairs with the sleepers / generation handshake in worker_loop: either a worker about to sleep
+    // sees the new job on its final scan, or this sees the sleeper and wakes it.
+    void wake(bool all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!all && sleepers.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+        generation.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+        }
+        if (all) {
+            sleep_condition.notify_all();
+        } else {
+            sleep_condition.notify_one();
+        }
+    }
+
+    detail::pool_job* take_injected() {
+        if (injected_count.load(std::memory_order_seq_cst) == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(injection_mutex);
+        if (injected.empty()) {
+            return nullptr;
+        }
+        detail::pool_job *job = injected.front();
+        injected.pop_front();
+        injected_count.fetch_sub(1, std::memory_order_seq_cst);
+        return job;
+    }
+
+    // own deque first, then the injection queue, then steal starting from a rotating victim
+    detail::pool_job* find_job(bool own, size_t self, size_t &victim) {
+        if (own) {
+            if (detail::pool_job *job = workers[self]->jobs.take()) {
+                return job;
+            }
+        }
+        if (detail::pool_job *job = take_injected()) {
+            return job;
+        }
+        for (size_t attempt = 0; attempt < workers.size(); ++attempt) {
+            victim = (victim + 1) % workers.size();
+            if (own && victim == self) continue;
+            if (detail::pool_job *job = workers[victim]->jobs.steal()) {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void worker_loop(size_t self) {
+        context() = worker_context{this, self};
+        size_t victim = self;
+        while (true) {
+            if (detail::pool_job *job = find_job(true, self, victim)) {
+                job->execute(job);
+                continue;
+            }
+
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            std::uint64_t observed = generation.load(std::memory_order_seq_cst);
+            if (detail::pool_job *job = find_job(true, self, victim)) {
+                sleepers.fetch_sub(1, std::memory_order_seq_cst);
+                job->execute(job);
+                continue;
+            }
+            if (stop.load(std::memory_order_seq_cst)) {
+                // nothing left anywhere and no new work will come
+                sleepers.fetch_sub(1, std::memory_order_seq_cst);
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+                sleep_condition.wait(lock, [this, observed]() -> bool {
+                    return stop.load(std::memory_order_seq_cst)
+                        || generation.load(std::memory_order_seq_cst) != observed;
+                });
+            }
+            sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        }
+    }
+
+    // Workers keep executing jobs while they wait so nested parallel_for calls can not starve the pool;
+    // other threads help while there is work to grab and block once there is none.
+    void wait_for(range_state_base &state) {
+        bool own = is_own_worker();
+        size_t self = own ? context().index : 0;
+        size_t victim = self;
+        while (state.pending.load(std::memory_order_acquire) != 0) {
+            if (detail::pool_job *job = find_job(own, self, victim)) {
+                job->execute(job);
+            } else if (own) {
+                std::this_thread::yield();
+            } else {
+                break;
+            }
+        }
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.finished.wait(lock, [&state]() -> bool { return state.done; });
+    }
+
+    std::vector<std::unique_ptr<worker>> workers;
+
+    std::deque<detail::pool_job *> injected;
+    std::mutex injection_mutex;
+    std::atomic<size_t> injected_count{0};
+
+    std::atomic<size_t> sleepers{0};
+    std::atomic<std::uint64_t> generation{0};
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_condition;
+    std::atomic<bool> stop{false};
 };
 
+// In place exclusive prefix sum over values, split into blocks of `grain` elements; returns the total
+template <typename T>
+T parallel_exclusive_scan(thread_pool &pool, std::vector<T> &values, size_t grain) {
+    grain = std::max<size_t>(grain, 1);
+    std::vector<T> block_sums((values.size() + grain - 1) / grain, T());
+    pool.parallel_for(0, values.size(), grain, [&](size_t first, size_t last) {
+        T sum = T();
+        for (size_t i = first; i < last; ++i) {
+            sum += values[i];
+        }
+        block_sums[first / grain] = sum;
+    });
+
+    T total = T();
+    for (T &block_sum : block_sums) {
+        T sum = block_sum;
+        block_sum = total;
+        total += sum;
+    }
+
+    pool.parallel_for(0, values.size(), grain, [&](size_t first, size_t last) {
+        T running = block_sums[first / grain];
+        for (size_t i = first; i < last; ++i) {
+            T value = values[i];
+            values[i] = running;
+            running += value;
+        }
+    });
+    return total;
+}
+
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "analyzer/AssignmentEvaluator.hpp"
+#include "constants.hpp"
+#include "util/thread_pool.hpp"
+
+namespace analyzer {
+
+EdgeArrays::EdgeArrays(const pcp::BinaryCSP &pcp) : variables(pcp.get_size()) {
+    const auto &constraints_list = pcp.get_constraints_list();
+    u.reserve(constraints_list.size());
+    v.reserve(constraints_list.size());
+    type.reserve(constraints_list.size());
+    for (const auto &[a, b, c] : constraints_list) {
+        u.push_back(a);
+        v.push_back(b);
+        type.push_back(make_rule(c));
+    }
+    // a gather reads the value byte and the 3 bytes after it
+    const pcp::Variable gather_end = static_cast<pcp::Variable>(variables < 3 ? 0 : variables - 3);
+    gather_safe.assign((size() + BLOCK - 1) / BLOCK, 1);
+    for (size_t e = 0; e < size(); ++e) {
+        if (u[e] >= gather_end || v[e] >= gather_end) gather_safe[e / BLOCK] = 0;
+    }
+}
+
+namespace {
+
+size_t count_satisfied_scalar(const EdgeArrays &edges, const std::uint8_t *values, size_t first, size_t last) {
+    size_t satisfied = 0;
+    for (size_t e = first; e < last; ++e) {
+        satisfied += EdgeArrays::satisfied(edges.type[e], values[edges.u[e]], values[edges.v[e]]);
+    }
+    return satisfied;
+}
+
+#ifdef __AVX2__
+// packed values of 4 variables as the low bytes of 32-bit lanes, gathered with 64-bit indices
+inline __m128i gather_values(const std::uint8_t *values, const pcp::Variable *vars) {
+    __m256i index;
+    if constexpr (sizeof(pcp::Variable) == 8) {
+        index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(vars));
+    } else {
+        index = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(vars)));
+    }
+    return _mm256_i64gather_epi32(reinterpret_cast<const int *>(values), index, 1);
+}
+
+// One block of BLOCK edges per step: the masked bits of the two gathered values agree iff (x ^ y) & rule is zero,
+// negated rules flip the result. The bytes above the value in every lane are cleared by the rule mask. Blocks not
+// marked gather_safe, and the partial blocks at both ends of the range, are evaluated one edge at a time.
+size_t count_satisfied_avx2(const EdgeArrays &edges, const std::uint8_t *values, size_t first, size_t last) {
+    const __m256i value_mask = _mm256_set1_epi32(static_cast<std::uint8_t>(~EdgeArrays::NEGATED_BIT));
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i count = _mm256_setzero_si256();
+    size_t e = std::min(last, (first + EdgeArrays::BLOCK - 1) / EdgeArrays::BLOCK * EdgeArrays::BLOCK);
+    size_t satisfied = count_satisfied_scalar(edges, values, first, e);
+    for (; e + EdgeArrays::BLOCK <= last; e += EdgeArrays::BLOCK) {
+        if (!edges.gather_safe[e / EdgeArrays::BLOCK]) {
+            satisfied += count_satisfied_scalar(edges, values, e, e + EdgeArrays::BLOCK);
+            continue;
+        }
+        __m256i x = _mm256_set_m128i(gather_values(values, &edges.u[e + 4]), gather_values(values, &edges.u[e]));
+        __m256i y = _mm256_set_m128i(gather_values(values, &edges.v[e + 4]), gather_values(values, &edges.v[e]));
+        __m256i rule = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(&edges.type[e])));
+        __m256i differ = _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_and_si256(rule, value_mask));
+        __m256i agree = _mm256_and_si256(_mm256_cmpeq_epi32(differ, _mm256_setzero_si256()), one);
+        count = _mm256_add_epi32(count, _mm256_xor_si256(agree, _mm256_srli_epi32(rule, 7)));
+    }
+    alignas(32) std::uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), count);
+    for (std::uint32_t lane : lanes) satisfied += lane;
+    return satisfied + count_satisfied_scalar(edges, values, e, last);
+}
+#endif
+
+}
+
+size_t count_satisfied(const EdgeArrays &edges, const std::uint8_t *values, size_t first, size_t last) {
+#ifdef __AVX2__
+    if constexpr (sizeof(pcp::Variable) <= 8) {
+        // lane counts are 32 bits wide
+        size_t satisfied = 0;
+        for (size_t begin = first; begin < last; begin += constants::EVALUATE_CHUNK_SIZE) {
+            satisfied += count_satisfied_avx2(edges, values, begin, std::min(last, begin + constants::EVALUATE_CHUNK_SIZE));
+        }
+        return satisfied;
+    }
+#endif
+    return count_satisfied_scalar(edges, values, first, last);
+}
+
+size_t count_satisfied(const EdgeArrays &edges, const std::uint8_t *values) {
+    const size_t total = edges.size();
+#ifndef SINGLE_THREAD
+    if (total >= constants::EVALUATE_PARALLEL_THRESHOLD) {
+        // one slot per chunk, summed in order
+        const size_t chunks = (total + constants::EVALUATE_CHUNK_SIZE - 1) / constants::EVALUATE_CHUNK_SIZE;
+        std::vector<size_t> satisfied(chunks, 0);
+        unsigned int num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = constants::SAFE_THREAD_NUMBER;
+        util::thread_pool pool(std::min<size_t>(num_threads, chunks));
+        pool.parallel_for(0, chunks, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                size_t begin = c * constants::EVALUATE_CHUNK_SIZE;
+                satisfied[c] = count_satisfied(edges, values, begin, std::min(total, begin + constants::EVALUATE_CHUNK_SIZE));
+            }
+        });
+        size_t sum = 0;
+        for (size_t count : satisfied) sum += count;
+        return sum;
+    }
+#endif
+    return count_satisfied(edges, values, 0, total);
+}
+
+double evaluate_assignment(const pcp::BinaryCSP &pcp, const std::vector<pcp::BinaryDomain> &assignment) {
+    if (assignment.size() != pcp.get_size()) {
+        throw std::invalid_argument("evaluate_assignment: assignment size does not match the number of variables");
+    }
+    if (pcp.get_constraints_list().empty()) {
+        return 1.0;
+    }
+    std::vector<std::uint8_t> values(assignment.size());
+    for (size_t i = 0; i < assignment.size(); ++i) {
+        values[i] = assignment[i].get_packed();
+    }
+    EdgeArrays edges(pcp);
+    return static_cast<double>(count_satisfied(edges, values.data())) / static_cast<double>(edges.size());
+}
+
+double evaluate_assignment(const pcp::BinaryCSP &pcp) {
+    return evaluate_assignment(pcp, pcp.get_variables());
+}
+
+}
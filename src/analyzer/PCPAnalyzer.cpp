@@ -1,45 +1,178 @@
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <random>
+#include <thread>
 
 #include "analyzer/PCPAnalyzer.hpp"
 #include "constants.hpp"
+#include "util/thread_pool.hpp"
 
 namespace analyzer {
 
+namespace {
+
+// z such that P(Z > z) = tail for a standard normal Z, by bisection on erfc
+double normal_quantile(double tail) {
+    double lo = 0, hi = 40;
+    for (int step = 0; step < 200; ++step) {
+        double mid = (lo + hi) / 2;
+        if (0.5 * std::erfc(mid / std::sqrt(2.0)) > tail) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo + hi) / 2;
+}
+
+// Two-sided interval at level 1 - delta on the acceptance probability after `accepted` successes in `queries` trials
+AcceptanceEstimate make_estimate(size_t accepted, size_t queries, double delta, IntervalMethod method) {
+    if (queries == 0) {
+        return {0, 0, 1, 0};
+    }
+    const double n = static_cast<double>(queries);
+    const double p = accepted / n;
+    double lower, upper;
+    if (method == IntervalMethod::WILSON) {
+        const double z = normal_quantile(delta / 2);
+        const double z2 = z * z;
+        const double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+        const double half = z / (1 + z2 / n) * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n));
+        lower = center - half;
+        upper = center + half;
+    } else {
+        const double half = std::sqrt(std::log(2 / delta) / (2 * n));
+        lower = p - half;
+        upper = p + half;
+    }
+    return {p, std::clamp(lower, 0.0, p), std::clamp(upper, p, 1.0), queries};
+}
+
+// Runs body(first, last) over [0, tasks) on a pool sized to the machine
+template <typename Body>
+void run_tasks(size_t tasks, Body &&body) {
+#ifndef SINGLE_THREAD
+    if (tasks > 1) {
+        unsigned int num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = constants::SAFE_THREAD_NUMBER;
+        util::thread_pool pool(std::min<size_t>(num_threads, tasks));
+        pool.parallel_for(0, tasks, 1, body);
+        return;
+    }
+#endif
+    body(0, tasks);
+}
+
+}
+
 PCPAnalyzer::PCPAnalyzer(const std::vector<std::pair<pcp::BinaryCSP, Satisfiability>> &samples, const int num_trial)
- : samples(samples), 
+ : samples(samples),
    num_trial(num_trial),
    soundness(0),
    completeness(0) {
-    int true_positive = 0;
-    int false_positive = 0;
-    int accepted = 0;
-    for (const auto &[sample, satisfiable] : samples) {
-        int cnt = 0;
-        for (int i = 0; i < num_trial; ++i) {
-            bool satisfied = query(sample);
-            cnt += satisfied ? 1 : 0;
+    // accepted[i * chunks_per_sample + c] counts the satisfied queries of chunk c of sample i
+    const size_t trials = static_cast<size_t>(std::max(num_trial, 0));
+    const size_t chunks_per_sample = (trials + constants::QUERY_CHUNK_SIZE - 1) / constants::QUERY_CHUNK_SIZE;
+    const size_t total_chunks = samples.size() * chunks_per_sample;
+    std::vector<size_t> accepted(total_chunks, 0);
+
+    auto run_chunks = [&](size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; ++chunk) {
+            size_t i = chunk / chunks_per_sample;
+            size_t c = chunk % chunks_per_sample;
+            size_t count = std::min(constants::QUERY_CHUNK_SIZE, trials - c * constants::QUERY_CHUNK_SIZE);
+            util::philox rng = constants::random_stream(constants::RandomStage::ANALYZER, i, c);
+            accepted[chunk] = query_batch(samples[i].first, count, rng);
         }
-        if (satisfiable) {
-            ++accepted;
-            true_positive += cnt;
-        } else {
-            false_positive += cnt;
+    };
+    run_tasks(total_chunks, run_chunks);
+
+    // union bound over the samples, so that the averaged intervals hold at 1 - QUERY_CONFIDENCE_DELTA
+    const double delta = constants::QUERY_CONFIDENCE_DELTA / std::max<size_t>(samples.size(), 1);
+    estimates.resize(samples.size());
+    queries_used = trials * samples.size();
+    for (size_t i = 0; i < samples.size(); ++i) {
+        size_t cnt = 0;
+        for (size_t c = 0; c < chunks_per_sample; ++c) {
+            cnt += accepted[i * chunks_per_sample + c];
         }
+        estimates[i] = make_estimate(cnt, trials, delta, IntervalMethod::WILSON);
     }
+    summarize();
+}
+
+PCPAnalyzer::PCPAnalyzer(const std::vector<std::pair<pcp::BinaryCSP, Satisfiability>> &samples, const int num_trial,
+    double interval_width, IntervalMethod method)
+ : samples(samples),
+   num_trial(num_trial),
+   soundness(0),
+   completeness(0) {
+    const size_t trials = static_cast<size_t>(std::max(num_trial, 0));
+    const size_t chunks_per_sample = (trials + constants::QUERY_CHUNK_SIZE - 1) / constants::QUERY_CHUNK_SIZE;
+    // union bound over the samples and over the chunk boundaries the interval is checked at
+    const double delta = constants::QUERY_CONFIDENCE_DELTA / std::max<size_t>(samples.size(), 1)
+        / std::max<size_t>(chunks_per_sample, 1);
+    estimates.assign(samples.size(), make_estimate(0, 0, delta, method));
 
-    if (num_trial * accepted == 0) {
+    run_tasks(samples.size(), [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            size_t accepted = 0;
+            size_t queries = 0;
+            for (size_t c = 0; c < chunks_per_sample; ++c) {
+                size_t count = std::min(constants::QUERY_CHUNK_SIZE, trials - queries);
+                util::philox rng = constants::random_stream(constants::RandomStage::ANALYZER, i, c);
+                accepted += query_batch(samples[i].first, count, rng);
+                queries += count;
+                estimates[i] = make_estimate(accepted, queries, delta, method);
+                if (estimates[i].upper - estimates[i].lower <= interval_width) {
+                    break;
+                }
+            }
+        }
+    });
+
+    queries_used = 0;
+    for (const AcceptanceEstimate &estimate : estimates) {
+        queries_used += estimate.queries;
+    }
+    summarize();
+}
+
+// completeness and soundness are the mean acceptance of the satisfiable and unsatisfiable samples that were queried
+void PCPAnalyzer::summarize() {
+    double accepted[2] = {0, 0}, lower[2] = {0, 0}, upper[2] = {0, 0};
+    size_t counted[2] = {0, 0};
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (estimates[i].queries == 0) {
+            continue;
+        }
+        int group = samples[i].second ? 1 : 0;
+        accepted[group] += estimates[i].acceptance;
+        lower[group] += estimates[i].lower;
+        upper[group] += estimates[i].upper;
+        ++counted[group];
+    }
+
+    if (counted[1] == 0) {
         completeness = 1;
+        completeness_interval = {1, 1};
     } else {
-        completeness = 1.0 * true_positive / num_trial / accepted;
+        completeness = accepted[1] / counted[1];
+        completeness_interval = {lower[1] / counted[1], upper[1] / counted[1]};
     }
 
-    if (num_trial * (samples.size() - accepted) == 0) {
+    if (counted[0] == 0) {
         soundness = 0;
+        soundness_interval = {0, 0};
     } else {
-        soundness = 1.0 * false_positive / num_trial / (samples.size() - accepted);
+        soundness = accepted[0] / counted[0];
+        soundness_interval = {lower[0] / counted[0], upper[0] / counted[0]};
     }
-    
+
     gap = completeness - soundness;
 }
 
@@ -49,6 +182,14 @@ double PCPAnalyzer::getGap() { return gap; };
 
 double PCPAnalyzer::getCompleteness() { return completeness; };
 
+std::pair<double, double> PCPAnalyzer::getSoundnessInterval() const { return soundness_interval; }
+
+std::pair<double, double> PCPAnalyzer::getCompletenessInterval() const { return completeness_interval; }
+
+const std::vector<AcceptanceEstimate>& PCPAnalyzer::getEstimates() const { return estimates; }
+
+size_t PCPAnalyzer::getQueriesUsed() const { return queries_used; }
+
 // perform a single uniformly random query on sample
 bool query(const pcp::BinaryCSP &sample) {
     const auto &constraints_list = sample.get_constraints_list();
@@ -58,7 +199,35 @@ bool query(const pcp::BinaryCSP &sample) {
     std::uniform_int_distribution<int> dist(0, constraints_list.size() - 1);
     int r = dist(constants::RANDOM_SEED);
     const auto &[v1, v2, constraint] = constraints_list[r];
-    return constraint::evaluateBinaryConstraint(constraint, sample.get_variable(v1), sample.get_variable(v2));
+    return constraint::evaluatePackedBinaryConstraint(constraint, sample.get_variable(v1).get_packed(), sample.get_variable(v2).get_packed());
 }
 
-}
\ No newline at end of file
+size_t query_batch(const pcp::BinaryCSP &sample, size_t count, util::philox &rng) {
+    const auto &constraints_list = sample.get_constraints_list();
+    if (constraints_list.empty()) {
+        return count; // no constraints, always satisfied
+    }
+    const std::vector<pcp::BinaryDomain> &variables = sample.get_variables();
+
+    // one draw of the generator per index unless there are more than 2^32 constraints
+    const size_t last_index = constraints_list.size() - 1;
+    const bool narrow = last_index <= std::numeric_limits<std::uint32_t>::max();
+    std::uniform_int_distribution<std::uint32_t> narrow_dist(0, static_cast<std::uint32_t>(std::min<size_t>(last_index, std::numeric_limits<std::uint32_t>::max())));
+    std::uniform_int_distribution<size_t> wide_dist(0, last_index);
+
+    std::array<size_t, constants::QUERY_BATCH_SIZE> picked;
+    size_t satisfied = 0;
+    for (size_t done = 0; done < count; done += constants::QUERY_BATCH_SIZE) {
+        size_t batch = std::min(constants::QUERY_BATCH_SIZE, count - done);
+        for (size_t k = 0; k < batch; ++k) {
+            picked[k] = narrow ? narrow_dist(rng) : wide_dist(rng);
+        }
+        for (size_t k = 0; k < batch; ++k) {
+            const auto &[v1, v2, constraint] = constraints_list[picked[k]];
+            satisfied += constraint::evaluatePackedBinaryConstraint(constraint, variables[v1].get_packed(), variables[v2].get_packed());
+        }
+    }
+    return satisfied;
+}
+
+}
@@ -1,139 +1,666 @@
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <optional>
 #include <vector>
 #include <random>
-#include <map>
+#include <stdexcept>
+#include <string>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <utility>
 
 #include "constants.hpp"
+#include "analyzer/AssignmentEvaluator.hpp"
 #include "analyzer/SoundnessApproximater.hpp"
 #include "constraint/BinaryConstraint.hpp"
+#include "util/bfs_workspace.hpp"
+#include "util/philox.hpp"
+#include "util/thread_pool.hpp"
 
 namespace analyzer {
 
-double approximate_soundness(pcp::BinaryCSP &pcp, size_t iter_per_temp) {
-    // Gather constraints list
-    const auto &constraints_list = pcp.get_constraints_list();
-    size_t m = constraints_list.size();
+namespace {
 
-    if (m == 0) return 1.0; // no constraints
+// Annealing moves compiled from a BinaryCSP and shared by all chains. Constraints are stored in CSR form as one
+// EdgeArrays rule byte each, and the domain of every variable is resolved to a slice of one flat table of packed values.
+class move_kernel {
+public:
+    // domain types fit in the bits of BinaryDomain above the value
+    static constexpr size_t DOMAIN_TYPES = 1 << (8 - pcp::BinaryDomain::VALUE_BITS);
 
-    // Function to count number of satisfied constraints
-    auto count_satisfied = [&]() {
-        int count = 0;
-        for (const auto &[var1, var2, constraint] : constraints_list) {
-            pcp::BinaryDomain val1 = pcp.get_variable(var1);
-            pcp::BinaryDomain val2 = pcp.get_variable(var2);
-            count += constraint::evaluateBinaryConstraint(constraint, val1, val2) ? 1 : 0;
+    // with_edge_ids: also record which edge of the list every CSR entry is, for engines tracking violated edges
+    explicit move_kernel(const pcp::BinaryCSP &pcp, bool with_edge_ids = false)
+     : size(pcp.get_size()), offsets(pcp.get_size() + 1, 0), edges(pcp) {
+        for (const auto &[domain_type, opts] : possible_values) {
+            size_t d = static_cast<size_t>(domain_type);
+            domain_begin[d] = static_cast<std::uint8_t>(flat_values.size());
+            domain_size[d] = static_cast<std::uint8_t>(opts.size());
+            for (const auto &value : opts) flat_values.push_back(value.get_packed());
         }
-        return count;
-    };
 
-    // Function to count number of satisfied constraints involving a specific variable
-    auto count_local_satisfied = [&](pcp::Variable changed_var) {
-        int count = 0;
-        for (const auto &[other_var, constraint] : pcp.get_constraints(changed_var)) {
-            pcp::BinaryDomain val1 = pcp.get_variable(changed_var);
-            pcp::BinaryDomain val2 = pcp.get_variable(other_var);
-            count += constraint::evaluateBinaryConstraint(constraint, val1, val2) ? 1 : 0;
+        for (size_t e = 0; e < edges.size(); ++e) {
+            ++offsets[edges.u[e] + 1];
+            ++offsets[edges.v[e] + 1];
         }
-        return count;
-    };
+        for (size_t i = 0; i < size; ++i) {
+            max_degree = std::max<size_t>(max_degree, offsets[i + 1]);
+            offsets[i + 1] += offsets[i];
+        }
+        // same row order as FrozenBinaryCSP
+        neighbors.resize(offsets.back());
+        rules.resize(offsets.back());
+        if (with_edge_ids) edge_ids.resize(offsets.back());
+        std::vector<pcp::Index> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t e = 0; e < edges.size(); ++e) {
+            const pcp::Variable u = edges.u[e], v = edges.v[e];
+            if (with_edge_ids) {
+                edge_ids[cursor[u]] = e;
+                edge_ids[cursor[v]] = e;
+            }
+            neighbors[cursor[u]] = v;
+            rules[cursor[u]++] = edges.type[e];
+            neighbors[cursor[v]] = u;
+            rules[cursor[v]++] = edges.type[e];
+        }
+    }
+
+    static int satisfied(std::uint8_t rule, std::uint8_t x, std::uint8_t y) { return EdgeArrays::satisfied(rule, x, y); }
 
-    // Initialize each variable randomly from its domain's possible values
-    for (pcp::Variable i = 0; i < static_cast<pcp::Variable>(pcp.get_size()); ++i) {
-        auto domain_type = pcp.get_variable(i).get_domain_type();
-        const auto &opts = possible_values.at(domain_type);
-        if (!opts.empty()) {
-            std::uniform_int_distribution<size_t> dist(0, opts.size() - 1);
-            pcp.set_variable(i, opts[dist(constants::RANDOM_SEED)]);
+    size_t size;
+    size_t max_degree = 0;
+    // constraints of variable i live in [offsets[i], offsets[i + 1]) of neighbors and rules
+    std::vector<pcp::Index> offsets;
+    std::vector<pcp::Variable> neighbors;
+    std::vector<std::uint8_t> rules;
+    // position in the edge list of every CSR entry, empty unless requested
+    std::vector<pcp::Index> edge_ids;
+    // the edge list, for counting satisfied constraints from scratch
+    EdgeArrays edges;
+    // values of domain type d are flat_values[domain_begin[d] .. domain_begin[d] + domain_size[d])
+    std::vector<std::uint8_t> flat_values;
+    std::uint8_t domain_begin[DOMAIN_TYPES] = {};
+    std::uint8_t domain_size[DOMAIN_TYPES] = {};
+};
+
+// Random initial assignment: every variable gets a uniformly random value of its domain. option[i] is the index of
+// values[i] within its domain's slice of the kernel's flat table.
+void random_assignment(const move_kernel &kernel, const pcp::BinaryCSP &pcp, util::philox &rng,
+    std::vector<std::uint8_t> &values, std::vector<std::uint8_t> &option) {
+    values.resize(kernel.size);
+    option.assign(kernel.size, 0);
+    for (size_t i = 0; i < kernel.size; ++i) {
+        values[i] = pcp.get_variable(static_cast<pcp::Variable>(i)).get_packed();
+        size_t d = values[i] >> pcp::BinaryDomain::VALUE_BITS;
+        if (kernel.domain_size[d] > 0) {
+            std::uniform_int_distribution<int> dist(0, kernel.domain_size[d] - 1);
+            option[i] = static_cast<std::uint8_t>(dist(rng));
+            values[i] = kernel.flat_values[kernel.domain_begin[d] + option[i]];
         }
     }
+}
 
-    int current_satisfied = count_satisfied();
-    int best_satisfied = current_satisfied;
+// One annealing chain. The move kernel is shared by all chains, the assignment is private to the chain.
+class annealing_chain {
+public:
+    annealing_chain(const move_kernel &kernel, const pcp::BinaryCSP &pcp, util::philox rng)
+     : kernel(kernel), rng(rng),
+       var_dist(0, static_cast<pcp::Variable>(std::max<size_t>(1, kernel.size) - 1)) {
+        random_assignment(kernel, pcp, this->rng, values, option);
+        if (kernel.size > 0 && kernel.size - 1 <= std::numeric_limits<std::uint32_t>::max()) {
+            narrow_var_dist.emplace(0, static_cast<std::uint32_t>(kernel.size - 1));
+        }
+        for (size_t n = 2; n < other_option.size(); ++n) {
+            other_option[n] = std::uniform_int_distribution<int>(0, static_cast<int>(n) - 2);
+        }
+        current_satisfied = count_satisfied();
+        best_satisfied = current_satisfied;
+    }
 
-    std::uniform_int_distribution<pcp::Variable> var_dist(0, static_cast<pcp::Variable>(std::max<size_t>(1, pcp.get_size()) - 1));
+    // Metropolis moves at temperature T, returns whether the best satisfied count improved
+    bool run(double T, size_t iterations) {
+        // acceptance probabilities exp(-loss / T) of the losses a move can cause, scaled to one draw of the generator
+        acceptance.resize(std::min(kernel.max_degree, ACCEPTANCE_TABLE_SIZE) + 1);
+        for (size_t loss = 0; loss < acceptance.size(); ++loss) {
+            acceptance[loss] = static_cast<std::uint64_t>(std::ldexp(std::exp(-static_cast<double>(loss) / T), 32));
+        }
 
-    double T = startingT;
+        int previous_best = best_satisfied;
+        for (size_t it = 0; it < iterations; ++it, ++moves) {
+            // pick random variable, with a single draw unless there are more than 2^32 variables
+            pcp::Variable v = narrow_var_dist ? narrow_var_dist->operator()(rng) : var_dist(rng);
+            size_t d = values[v] >> pcp::BinaryDomain::VALUE_BITS;
+            size_t options = kernel.domain_size[d];
+            if (options <= 1) continue; // nothing to change
 
-    while (T > Tmin) {
-        for (size_t it = 0; it < iter_per_temp; ++it) {
-            // pick random variable
-            pcp::Variable v = var_dist(constants::RANDOM_SEED);
-            auto domain_type = pcp.get_variable(v).get_domain_type();
-            const auto &opts = possible_values.at(domain_type);
-            if (opts.size() <= 1) continue; // nothing to change
+            // pick a new random value different from current by skipping over the current option
+            int cand = other_option[options](rng);
+            if (cand >= option[v]) ++cand;
+            std::uint8_t old = values[v];
+            std::uint8_t next = kernel.flat_values[kernel.domain_begin[d] + cand];
 
-            // pick a new random value different from current
-            std::uniform_int_distribution<size_t> opt_dist(0, opts.size() - 1);
-            pcp::BinaryDomain old = pcp.get_variable(v);
-            pcp::BinaryDomain cand;
-            // ensure different
-            for (int tries = 0; tries < 10; ++tries) {
-                cand = opts[opt_dist(constants::RANDOM_SEED)];
-                if (!(cand == old)) break;
+            // old and new satisfaction of every incident constraint in one pass
+            int delta = 0;
+            for (pcp::Index e = kernel.offsets[v]; e < kernel.offsets[v + 1]; ++e) {
+                std::uint8_t other = values[kernel.neighbors[e]];
+                delta += move_kernel::satisfied(kernel.rules[e], next, other) - move_kernel::satisfied(kernel.rules[e], old, other);
             }
-            if (cand == old) continue;
 
-            int previous_satisfied = count_local_satisfied(v);
-            // apply candidate
-            pcp.set_variable(v, cand);
-            int new_satisfied = count_local_satisfied(v);
-            int delta = new_satisfied - previous_satisfied;
+            if (delta < 0) {
+                // accept with probability exp(delta / T) where delta is negative
+                size_t loss = static_cast<size_t>(-delta);
+                std::uint64_t threshold = loss < acceptance.size() ? acceptance[loss]
+                    : static_cast<std::uint64_t>(std::ldexp(std::exp(static_cast<double>(delta) / T), 32));
+                if (rng() >= threshold) continue;
+            }
+            values[v] = next;
+            option[v] = static_cast<std::uint8_t>(cand);
+            current_satisfied += delta;
+            ++flips;
+            if (current_satisfied > best_satisfied) {
+                best_satisfied = current_satisfied;
+                best_move = moves;
+            }
+        }
+        return best_satisfied > previous_best;
+    }
+
+    int get_current_satisfied() const { return current_satisfied; }
+
+    int get_best_satisfied() const { return best_satisfied; }
+
+    size_t get_flips() const { return flips; }
+
+    // fraction of this chain's moves made before it first reached its best
+    double best_progress() const { return moves == 0 ? 0.0 : static_cast<double>(best_move) / static_cast<double>(moves); }
+
+    pcp::BinaryDomain get_value(pcp::Variable var) const { return pcp::BinaryDomain::from_packed(values[var]); }
+
+private:
+    static constexpr size_t ACCEPTANCE_TABLE_SIZE = 64;
+
+    // Function to count number of satisfied constraints, chains already run on the pool so this stays on one thread
+    int count_satisfied() const {
+        return static_cast<int>(analyzer::count_satisfied(kernel.edges, values.data(), 0, kernel.edges.size()));
+    }
+
+    const move_kernel &kernel;
+    util::philox rng;
+    // packed values, and the index of each value within its domain's slice of the flat table
+    std::vector<std::uint8_t> values;
+    std::vector<std::uint8_t> option;
+    std::uniform_int_distribution<pcp::Variable> var_dist;
+    std::optional<std::uniform_int_distribution<std::uint32_t>> narrow_var_dist;
+    // other_option[n] draws one of the n - 1 options of a domain of size n that differ from the current one
+    std::array<std::uniform_int_distribution<int>, pcp::BinaryDomain::VALUE_MASK + 2> other_option;
+    // move accepted when a draw of rng is below acceptance[loss]
+    std::vector<std::uint64_t> acceptance;
+    int current_satisfied;
+    int best_satisfied;
+    // proposed moves, accepted moves, and proposed moves when best_satisfied was reached
+    size_t moves = 0;
+    size_t flips = 0;
+    size_t best_move = 0;
+};
+
+// WalkSAT style focused search. The violated constraints are kept in an index array with a position map, so picking
+// a random violated constraint and updating the set after a flip are both O(1) per affected constraint.
+class walk_search {
+public:
+    walk_search(const move_kernel &kernel, const pcp::BinaryCSP &pcp, util::philox rng, double noise)
+     : kernel(kernel), rng(rng), noise_threshold(static_cast<std::uint64_t>(std::ldexp(noise, 32))),
+       position(kernel.edges.size(), NOT_VIOLATED) {
+        random_assignment(kernel, pcp, this->rng, values, option);
+        for (size_t e = 0; e < kernel.edges.size(); ++e) {
+            if (!move_kernel::satisfied(kernel.edges.type[e], values[kernel.edges.u[e]], values[kernel.edges.v[e]])) {
+                add_violated(e);
+            }
+        }
+        best_violated = violated.size();
+    }
 
-            if (delta >= 0) {
-                current_satisfied += delta;
-                best_satisfied = std::max(best_satisfied, current_satisfied);
+    // steps until max_steps steps were made in total or nothing is violated
+    void run(size_t max_steps) {
+        while (steps < max_steps && !violated.empty()) {
+            ++steps;
+            pcp::Index e = violated[std::uniform_int_distribution<size_t>(0, violated.size() - 1)(rng)];
+            pcp::Variable ends[2] = {kernel.edges.u[e], kernel.edges.v[e]};
+
+            pcp::Variable v = ends[0];
+            int cand = -1;
+            if (rng() < noise_threshold) {
+                // random walk: a random other value of a random end
+                v = ends[rng() & 1];
+                size_t options = kernel.domain_size[values[v] >> pcp::BinaryDomain::VALUE_BITS];
+                if (options > 1) {
+                    cand = std::uniform_int_distribution<int>(0, static_cast<int>(options) - 2)(rng);
+                    if (cand >= option[v]) ++cand;
+                }
             } else {
-                // accept with probability exp(delta / T) where delta is negative
-                double prob = std::exp(static_cast<double>(delta) / T);
-                std::uniform_real_distribution<double> ud(0.0, 1.0);
-                if (ud(constants::RANDOM_SEED) < prob) {
-                    current_satisfied += delta;
-                } else {
-                    // revert
-                    pcp.set_variable(v, old);
+                // greedy: the value of either end satisfying the most constraints, ties broken uniformly
+                int best_delta = std::numeric_limits<int>::min();
+                size_t ties = 0;
+                for (pcp::Variable x : ends) {
+                    size_t d = values[x] >> pcp::BinaryDomain::VALUE_BITS;
+                    for (int o = 0; o < kernel.domain_size[d]; ++o) {
+                        if (o == option[x]) continue;
+                        int delta = gain(x, kernel.flat_values[kernel.domain_begin[d] + o]);
+                        if (delta > best_delta) {
+                            best_delta = delta;
+                            ties = 1;
+                            v = x;
+                            cand = o;
+                        } else if (delta == best_delta && std::uniform_int_distribution<size_t>(0, ties++)(rng) == 0) {
+                            v = x;
+                            cand = o;
+                        }
+                    }
                 }
             }
+            if (cand < 0) {
+                // neither end can change, so this constraint stays violated and the step is not a flip
+                continue;
+            }
+            flip(v, cand);
         }
-        T *= alpha;
     }
 
-    return static_cast<double>(best_satisfied) / static_cast<double>(m);
+    int get_best_satisfied() const { return static_cast<int>(kernel.edges.size() - best_violated); }
+
+    size_t get_flips() const { return flips; }
+
+    size_t get_steps() const { return steps; }
+
+    size_t get_best_step() const { return best_step; }
+
+    pcp::BinaryDomain get_value(pcp::Variable var) const { return pcp::BinaryDomain::from_packed(values[var]); }
+
+private:
+    static constexpr pcp::Index NOT_VIOLATED = std::numeric_limits<pcp::Index>::max();
+
+    // change in satisfied constraints if v took the packed value next
+    int gain(pcp::Variable v, std::uint8_t next) const {
+        int delta = 0;
+        for (pcp::Index e = kernel.offsets[v]; e < kernel.offsets[v + 1]; ++e) {
+            std::uint8_t other = values[kernel.neighbors[e]];
+            delta += move_kernel::satisfied(kernel.rules[e], next, other) - move_kernel::satisfied(kernel.rules[e], values[v], other);
+        }
+        return delta;
+    }
+
+    void flip(pcp::Variable v, int cand) {
+        size_t d = values[v] >> pcp::BinaryDomain::VALUE_BITS;
+        values[v] = kernel.flat_values[kernel.domain_begin[d] + cand];
+        option[v] = static_cast<std::uint8_t>(cand);
+        for (pcp::Index e = kernel.offsets[v]; e < kernel.offsets[v + 1]; ++e) {
+            pcp::Index edge = kernel.edge_ids[e];
+            bool now_satisfied = move_kernel::satisfied(kernel.rules[e], values[v], values[kernel.neighbors[e]]);
+            if (now_satisfied && position[edge] != NOT_VIOLATED) remove_violated(edge);
+            else if (!now_satisfied && position[edge] == NOT_VIOLATED) add_violated(edge);
+        }
+        ++flips;
+        if (violated.size() < best_violated) {
+            best_violated = violated.size();
+            best_step = steps;
+        }
+    }
+
+    void add_violated(pcp::Index e) {
+        position[e] = violated.size();
+        violated.push_back(e);
+    }
+
+    // move the last violated constraint into the hole left by e
+    void remove_violated(pcp::Index e) {
+        pcp::Index last = violated.back();
+        violated[position[e]] = last;
+        position[last] = position[e];
+        violated.pop_back();
+        position[e] = NOT_VIOLATED;
+    }
+
+    const move_kernel &kernel;
+    util::philox rng;
+    // random move when a draw of rng is below this
+    std::uint64_t noise_threshold;
+    std::vector<std::uint8_t> values;
+    std::vector<std::uint8_t> option;
+    // violated edges in any order, and the position of every edge in it or NOT_VIOLATED
+    std::vector<pcp::Index> violated;
+    std::vector<pcp::Index> position;
+    size_t best_violated;
+    // steps taken, and flips among them that changed a value
+    size_t steps = 0;
+    size_t flips = 0;
+    size_t best_step = 0;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
-double approximate_soundness_via_random_subset(pcp::BinaryCSP &pcp) {
-    auto constraint_list = pcp.get_constraints_list();
+// Report of a run of several chains in parallel that took `seconds`, the best chain being chains[best]
+void report_chains(const std::vector<annealing_chain> &chains, size_t best, int m, double seconds, SearchReport &report) {
+    report.soundness = static_cast<double>(chains[best].get_best_satisfied()) / static_cast<double>(m);
+    report.flips = 0;
+    for (const auto &chain : chains) report.flips += chain.get_flips();
+    report.seconds = seconds;
+    report.flips_per_second = seconds > 0 ? static_cast<double>(report.flips) / seconds : 0.0;
+    // the chains advance side by side, so the best chain's progress stands for the whole run
+    report.seconds_to_best = chains[best].best_progress() * seconds;
+}
 
-    double accumulated_soundness = 0.0;
+// Per thread buffers of approximate_soundness_via_random_subset, reused across repetitions
+struct subset_scratch {
+    // Draw `count` distinct indices of [0, size) in uniformly random order into indices, by the first `count` steps of
+    // a Fisher-Yates shuffle of the identity permutation. Only the displaced entries of the permutation are stored,
+    // so this is O(count^2) for the small subsets sampled here instead of O(size).
+    void sample(size_t size, size_t count, util::philox &rng) {
+        indices.clear();
+        displaced.clear();
+        auto at = [&](size_t position) {
+            for (const auto &[where, value] : displaced) {
+                if (where == position) return value;
+            }
+            return position;
+        };
+        auto set = [&](size_t position, size_t value) {
+            for (auto &[where, old] : displaced) {
+                if (where == position) {
+                    old = value;
+                    return;
+                }
+            }
+            displaced.emplace_back(position, value);
+        };
+        for (size_t i = 0; i < count; ++i) {
+            size_t j = std::uniform_int_distribution<size_t>(i, size - 1)(rng);
+            size_t picked = at(j);
+            set(j, at(i));
+            indices.push_back(picked);
+        }
+    }
+
+    static subset_scratch& local() {
+        thread_local subset_scratch scratch;
+        return scratch;
+    }
+
+    std::vector<size_t> indices;
+    // (position, value) of every entry of the virtual permutation that is not the identity
+    std::vector<std::pair<size_t, size_t>> displaced;
+    std::vector<pcp::BinaryDomain> variables;
+    std::vector<std::tuple<pcp::Variable, pcp::Variable, constraint::BinaryConstraint>> edges;
+};
+
+// Pool for running `tasks` independent tasks, or none when they should run on the calling thread
+std::unique_ptr<util::thread_pool> make_task_pool(size_t tasks) {
+#ifndef SINGLE_THREAD
+    if (tasks > 1) {
+        unsigned int num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = constants::SAFE_THREAD_NUMBER;
+        return std::make_unique<util::thread_pool>(std::min<size_t>(num_threads, tasks));
+    }
+#else
+    (void)tasks;
+#endif
+    return nullptr;
+}
+
+}
+
+double approximate_soundness(pcp::BinaryCSP &input, size_t iter_per_temp, std::uint64_t stream) {
+    return approximate_soundness_multi_chain(input, 1, iter_per_temp, stream);
+}
+
+double approximate_soundness_multi_chain(pcp::BinaryCSP &input, size_t chains, size_t iter_per_temp, std::uint64_t stream, SearchReport *report) {
+    if (input.get_constraints_list().empty()) { // no constraints
+        if (report) *report = SearchReport();
+        return 1.0;
+    }
+    chains = std::max<size_t>(chains, 1);
+    auto start = std::chrono::steady_clock::now();
+
+    // compile the moves once, the inner loop then walks contiguous adjacency arrays
+    const move_kernel kernel(input);
+    const int m = static_cast<int>(input.get_constraints_list().size());
+
+    std::vector<annealing_chain> chain;
+    chain.reserve(chains);
+    for (size_t k = 0; k < chains; ++k) {
+        chain.emplace_back(kernel, input, constants::random_stream(constants::RandomStage::ANNEALER, k, stream));
+    }
+
+    std::vector<double> temperatures;
+    for (double T = startingT; T > Tmin; T *= alpha) {
+        temperatures.push_back(T);
+    }
+
+    // a single chain runs on the calling thread, so callers may anneal many small CSPs in parallel themselves
+    std::unique_ptr<util::thread_pool> pool = make_task_pool(chains);
+    auto for_each_chain = [&](auto &&body) {
+        if (pool) pool->parallel_for(0, chains, 1, body);
+        else body(size_t(0), chains);
+    };
+
+    // chains run a whole epoch of temperature steps between two synchronisations; the stopping rule only looks at
+    // the state at epoch boundaries, so it does not depend on how the chains were scheduled
+    std::vector<size_t> last_improvement(chains, 0);
+    for (size_t epoch_begin = 0; epoch_begin < temperatures.size(); epoch_begin += steps_per_epoch) {
+        size_t epoch_end = std::min(temperatures.size(), epoch_begin + steps_per_epoch);
+        for_each_chain([&](size_t first, size_t last) {
+            for (size_t k = first; k < last; ++k) {
+                for (size_t step = epoch_begin; step < epoch_end; ++step) {
+                    if (chain[k].run(temperatures[step], iter_per_temp)) last_improvement[k] = step;
+                }
+            }
+        });
+
+        int best_satisfied = 0;
+        size_t latest_improvement = 0;
+        for (size_t k = 0; k < chains; ++k) {
+            best_satisfied = std::max(best_satisfied, chain[k].get_best_satisfied());
+            latest_improvement = std::max(latest_improvement, last_improvement[k]);
+        }
+        if (best_satisfied == m) break;
+        if (temperatures[epoch_end - 1] < plateau_temperature && epoch_end - latest_improvement > plateau_steps) break;
+    }
+
+    // best chain, the lowest index among equals
+    size_t best = 0;
+    for (size_t k = 1; k < chains; ++k) {
+        if (chain[k].get_best_satisfied() > chain[best].get_best_satisfied()) best = k;
+    }
+
+    if (report) report_chains(chain, best, m, seconds_since(start), *report);
+
+    // leave the final assignment of the best chain in the caller's BinaryCSP
+    for (pcp::Variable i = 0; i < static_cast<pcp::Variable>(input.get_size()); ++i) {
+        input.set_variable(i, chain[best].get_value(i));
+    }
+
+    return static_cast<double>(chain[best].get_best_satisfied()) / static_cast<double>(m);
+}
+
+TemperingResult approximate_soundness_tempering(pcp::BinaryCSP &input, size_t replicas, size_t swap_rounds, size_t moves_per_swap,
+    std::uint64_t stream, SearchReport *report) {
+    TemperingResult result{1.0, {}, {}};
+    if (input.get_constraints_list().empty()) { // no constraints
+        if (report) *report = SearchReport();
+        return result;
+    }
+    replicas = std::max<size_t>(replicas, 1);
+    auto start = std::chrono::steady_clock::now();
+
+    const move_kernel kernel(input);
+    const int m = static_cast<int>(input.get_constraints_list().size());
+
+    // replica k starts at temperature k of the ladder, hottest first; swaps exchange the temperatures of two
+    // replicas instead of copying their assignments
+    std::vector<annealing_chain> replica;
+    replica.reserve(replicas);
+    for (size_t k = 0; k < replicas; ++k) {
+        replica.emplace_back(kernel, input, constants::random_stream(constants::RandomStage::REPLICA_EXCHANGE, k + 1, stream));
+    }
+    std::vector<double> temperatures(replicas, tempering_min_T);
+    for (size_t t = 0; t + 1 < replicas; ++t) {
+        temperatures[t] = tempering_max_T * std::pow(tempering_min_T / tempering_max_T, static_cast<double>(t) / static_cast<double>(replicas - 1));
+    }
+    // at_temperature[t] is the replica currently running at temperatures[t]
+    std::vector<size_t> at_temperature(replicas);
+    std::iota(at_temperature.begin(), at_temperature.end(), 0);
+    std::vector<size_t> temperature_of(at_temperature);
 
-    for (int _ = 0; _ < constants::QUERY_SAMPLING_REPETITION; ++_) {
-        std::shuffle(constraint_list.begin(), constraint_list.end(), constants::RANDOM_SEED);
-        pcp::BinaryCSP sub_pcp;
-        std::map<pcp::Variable, pcp::Variable> var_mapping;
-        size_t subset_size = std::min<size_t>(constants::SUBSET_SIZE, constraint_list.size());
-        for (size_t i = 0; i < subset_size; ++i) {
-            auto [old_var1, old_var2, old_constraint] = constraint_list[i];
-            if (var_mapping.find(old_var1) == var_mapping.end()) {
-                pcp::BinaryDomain val = pcp.get_variable(old_var1);
-                pcp::Variable new_var = static_cast<pcp::Variable>(sub_pcp.get_size());
-                sub_pcp.add_variable(val);
-                var_mapping[old_var1] = new_var;
+    util::philox swap_rng = constants::random_stream(constants::RandomStage::REPLICA_EXCHANGE, 0, stream);
+    std::uniform_real_distribution<double> ud(0.0, 1.0);
+    std::vector<size_t> swap_attempts(replicas - 1, 0), swaps_accepted(replicas - 1, 0);
+
+    std::unique_ptr<util::thread_pool> pool = make_task_pool(replicas);
+    auto for_each_replica = [&](auto &&body) {
+        if (pool) pool->parallel_for(0, replicas, 1, body);
+        else body(size_t(0), replicas);
+    };
+
+    int best_satisfied = 0;
+    result.trace.reserve(swap_rounds);
+    for (size_t round = 0; round < swap_rounds; ++round) {
+        for_each_replica([&](size_t first, size_t last) {
+            for (size_t k = first; k < last; ++k) {
+                replica[k].run(temperatures[temperature_of[k]], moves_per_swap);
             }
-            if (var_mapping.find(old_var2) == var_mapping.end()) {
-                pcp::BinaryDomain val = pcp.get_variable(old_var2);
-                pcp::Variable new_var = static_cast<pcp::Variable>(sub_pcp.get_size());
-                sub_pcp.add_variable(val);
-                var_mapping[old_var2] = new_var;
+        });
+
+        for (const auto &r : replica) {
+            best_satisfied = std::max(best_satisfied, r.get_best_satisfied());
+        }
+        result.trace.push_back(static_cast<double>(best_satisfied) / static_cast<double>(m));
+        if (best_satisfied == m) break;
+
+        // alternate between even and odd neighbouring pairs so every pair is tried every other round
+        for (size_t t = round % 2; t + 1 < replicas; t += 2) {
+            size_t hot = at_temperature[t], cold = at_temperature[t + 1];
+            // accept with probability min(1, exp((1 / T_cold - 1 / T_hot) * (S_hot - S_cold))) for satisfied counts S
+            double exponent = (1.0 / temperatures[t + 1] - 1.0 / temperatures[t])
+                * static_cast<double>(replica[hot].get_current_satisfied() - replica[cold].get_current_satisfied());
+            ++swap_attempts[t];
+            if (exponent >= 0 || ud(swap_rng) < std::exp(exponent)) {
+                ++swaps_accepted[t];
+                std::swap(at_temperature[t], at_temperature[t + 1]);
+                temperature_of[hot] = t + 1;
+                temperature_of[cold] = t;
             }
-            sub_pcp.add_constraint(
-                var_mapping[old_var1],
-                var_mapping[old_var2],
-                old_constraint
-            );
         }
+    }
+
+    result.swap_acceptance.resize(replicas - 1);
+    for (size_t t = 0; t + 1 < replicas; ++t) {
+        result.swap_acceptance[t] = swap_attempts[t] == 0 ? 0.0 : static_cast<double>(swaps_accepted[t]) / static_cast<double>(swap_attempts[t]);
+    }
+
+    // best replica, the lowest index among equals
+    size_t best = 0;
+    for (size_t k = 1; k < replicas; ++k) {
+        if (replica[k].get_best_satisfied() > replica[best].get_best_satisfied()) best = k;
+    }
+    if (report) report_chains(replica, best, m, seconds_since(start), *report);
+    for (pcp::Variable i = 0; i < static_cast<pcp::Variable>(input.get_size()); ++i) {
+        input.set_variable(i, replica[best].get_value(i));
+    }
+
+    result.soundness = static_cast<double>(best_satisfied) / static_cast<double>(m);
+    return result;
+}
+
+SearchReport approximate_soundness_walksat(pcp::BinaryCSP &input, size_t max_flips, double noise, std::uint64_t stream) {
+    SearchReport report;
+    if (input.get_constraints_list().empty()) return report; // no constraints
+    auto start = std::chrono::steady_clock::now();
+
+    const move_kernel kernel(input, true);
+    const int m = static_cast<int>(input.get_constraints_list().size());
+    walk_search walk(kernel, input, constants::random_stream(constants::RandomStage::WALK, 0, stream), noise);
+    walk.run(max_flips);
+
+    report.soundness = static_cast<double>(walk.get_best_satisfied()) / static_cast<double>(m);
+    report.flips = walk.get_flips();
+    report.seconds = seconds_since(start);
+    report.flips_per_second = report.seconds > 0 ? static_cast<double>(report.flips) / report.seconds : 0.0;
+    report.seconds_to_best = walk.get_steps() == 0 ? 0.0
+        : report.seconds * static_cast<double>(walk.get_best_step()) / static_cast<double>(walk.get_steps());
 
-        double soundness_estimate = approximate_soundness(sub_pcp);
+    for (pcp::Variable i = 0; i < static_cast<pcp::Variable>(input.get_size()); ++i) {
+        input.set_variable(i, walk.get_value(i));
+    }
+    return report;
+}
+
+SearchReport run_soundness_engine(const std::string &engine, pcp::BinaryCSP &pcp, std::uint64_t stream) {
+    SearchReport report;
+    if (engine == "anneal") {
+        approximate_soundness_multi_chain(pcp, 1, iter_per_temp_default, stream, &report);
+    } else if (engine == "multi_chain") {
+        unsigned int num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = constants::SAFE_THREAD_NUMBER;
+        approximate_soundness_multi_chain(pcp, num_threads, iter_per_temp_default, stream, &report);
+    } else if (engine == "tempering") {
+        approximate_soundness_tempering(pcp, replicas_default, swap_rounds_default, moves_per_swap_default, stream, &report);
+    } else if (engine == "walksat") {
+        report = approximate_soundness_walksat(pcp, walk_flips_default, walk_noise_default, stream);
+    } else {
+        throw std::invalid_argument("run_soundness_engine: unknown engine " + engine);
+    }
+    return report;
+}
+
+double approximate_soundness_via_random_subset(pcp::BinaryCSP &pcp) {
+    const auto &constraint_list = pcp.get_constraints_list();
+    const size_t subset_size = std::min<size_t>(constants::SUBSET_SIZE, constraint_list.size());
+    const size_t repetitions = static_cast<size_t>(constants::QUERY_SAMPLING_REPETITION);
+
+    // every repetition anneals its own subset on the calling worker, the estimates are summed in order afterwards
+    std::vector<double> soundness_estimates(repetitions);
+    std::unique_ptr<util::thread_pool> pool = make_task_pool(repetitions);
+    auto sample = [&](size_t first, size_t last) {
+        subset_scratch &scratch = subset_scratch::local();
+        for (size_t rep = first; rep < last; ++rep) {
+            util::philox rng = constants::random_stream(constants::RandomStage::SUBSET_SAMPLING, rep);
+            scratch.sample(constraint_list.size(), subset_size, rng);
+
+            // dense original index to new index table, reset in O(1) by the workspace epoch
+            util::bfs_workspace &workspace = util::bfs_workspace::local();
+            workspace.start(pcp.get_size());
+            scratch.variables.clear();
+            scratch.edges.clear();
+            for (size_t i : scratch.indices) {
+                const auto &[old_var1, old_var2, old_constraint] = constraint_list[i];
+                pcp::Variable ends[2] = {old_var1, old_var2};
+                for (pcp::Variable &end : ends) {
+                    pcp::Variable local = workspace.lookup(end);
+                    if (local == util::bfs_workspace::NOT_MAPPED) {
+                        local = static_cast<pcp::Variable>(scratch.variables.size());
+                        workspace.map(end, local);
+                        scratch.variables.push_back(pcp.get_variable(end));
+                    }
+                    end = local;
+                }
+                scratch.edges.emplace_back(ends[0], ends[1], old_constraint);
+            }
+
+            pcp::BinaryCSP sub_pcp(std::vector<pcp::BinaryDomain>(scratch.variables), scratch.edges);
+            soundness_estimates[rep] = approximate_soundness(sub_pcp, iter_per_temp_default, rep);
+        }
+    };
+    if (pool) pool->parallel_for(0, repetitions, 1, sample);
+    else sample(0, repetitions);
+
+    double accumulated_soundness = 0.0;
+    for (double soundness_estimate : soundness_estimates) {
         accumulated_soundness += soundness_estimate;
     }
     return accumulated_soundness / static_cast<double>(constants::QUERY_SAMPLING_REPETITION);
@@ -1,174 +1,318 @@
+#include <algorithm>
+#include <atomic>
 #include <cmath>
-#include <future>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
 #include <thread>
-#include <unordered_map>
+#include <tuple>
 #include <vector>
 
 #include "core/core.hpp"
 #include "constants.hpp"
+#include "pcp/FrozenBinaryCSP.hpp"
+#include "pcp/Neighborhoods.hpp"
 #include "pcpp/TesterFactory.hpp"
-#include "util/disjoint_set_union.hpp"
+#include "util/bfs_workspace.hpp"
+#include "util/concurrent_disjoint_set_union.hpp"
+#include "util/philox.hpp"
+#include "util/span.hpp"
 #include "util/thread_pool.hpp"
 
-void merge_variables(
-    size_t original_size,
-    pcp::BinaryCSP &pcp, 
-    const std::vector<std::vector<std::pair<pcp::Variable, size_t>>> &occuring_location,
-    const std::vector<pcp::BinaryCSP> &reduced_pcps
-) {
-    
-    std::vector<size_t> offsets(1, 0);
-    offsets.reserve(original_size + 1);
-    for (const auto &reduced_pcp : reduced_pcps) {
-        offsets.push_back(offsets.back() + reduced_pcp.get_size());
-    }
+namespace core {
 
-    util::disjoint_set_union dsu(offsets.back());
-
-    for (pcp::Variable v = 0; v < static_cast<pcp::Variable>(original_size); ++v) {
-        if (occuring_location[v].size() <= 1) continue;
-        const auto &locations = occuring_location[v];
-        for (size_t i = 1; i < locations.size(); ++i) {
-            pcp::Variable u1 = locations[0].first;
-            size_t pos1 = locations[0].second;
-            pcp::Variable u2 = locations[i].first;
-            size_t pos2 = locations[i].second;
-
-            // merge the variables in DSU
-            dsu.merge(
-                offsets[u1] + pos1 * 3,
-                offsets[u2] + pos2 * 3
-            );
-            dsu.merge(
-                offsets[u1] + pos1 * 3 + 1,
-                offsets[u2] + pos2 * 3 + 1
-            );
-            dsu.merge(
-                offsets[u1] + pos1 * 3 + 2,
-                offsets[u2] + pos2 * 3 + 2
-            );
+namespace {
+
+// Output of gap amplification, assembled while the powering PCPs are still being built.
+// Batches of reduced PCPs are placed in order of u into one variable arena and one edge list, numbered exactly as
+// merge_BinaryCSPs would concatenate them, then written into their slots and merged with the variables they share
+// with other balls as soon as they are placed. finish() relabels and compacts the arena, so no concatenated,
+// merged or cleaned intermediate BinaryCSP is ever built.
+class amplified_output {
+public:
+    // merge_shared: merge the bits of a variable across every ball containing it (Hadamard tester)
+    amplified_output(size_t original_size, bool merge_shared)
+     : original_size(original_size),
+       merge_shared(merge_shared),
+       first_occurrence(merge_shared ? original_size : 0) {
+        for (auto &slot : first_occurrence) {
+            slot.store(NOT_SEEN, std::memory_order_relaxed);
         }
     }
-    
-    std::unordered_map<pcp::Variable, pcp::Variable> representative_map;
-    size_t new_size = 0;
-    for (pcp::Variable i = 0; i < offsets.back(); ++i) {
-        if (dsu.find(i) == i) {
-            representative_map[i] = new_size++;
+
+    // Make room in the arena for the next batch of reduced PCPs, the i-th of which is then filled by write(i, ...).
+    // Not thread safe, and the previous batch must be completely written first.
+    void place(util::span<pcp::BinaryCSP> batch) {
+        variable_offsets.resize(batch.size());
+        edge_offsets.resize(batch.size());
+        size_t variable_end = variables.size();
+        size_t edge_end = edges.size();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            variable_offsets[i] = variable_end;
+            edge_offsets[i] = edge_end;
+            variable_end += batch[i].get_size();
+            edge_end += batch[i].get_constraints_list().size();
+        }
+        // arena slots and relabelled indices are stored as pcp::Variable, before merging shrinks the arena
+        if constexpr (sizeof(pcp::Variable) < sizeof(size_t)) {
+            if (variable_end > static_cast<size_t>(std::numeric_limits<pcp::Variable>::max())) {
+                throw std::length_error("gap_amplification: arena size exceeds the range of pcp::Variable, rebuild with a wider PCP_VARIABLE_BITS");
+            }
+        }
+
+        size_t previously_placed = placed;
+        placed += batch.size();
+        if (previously_placed < constants::POWERING_WINDOW_SIZE && placed >= constants::POWERING_WINDOW_SIZE
+            && placed < original_size) {
+            // reduced PCPs of a bounded degree graph have similar sizes, size the arena after the first window
+            variables.reserve(variable_end * original_size / placed);
+            edges.reserve(edge_end * original_size / placed);
+            if (merge_shared) dsu.reserve(variable_end * original_size / placed);
         }
+        variables.resize(variable_end);
+        edges.resize(edge_end);
+        if (merge_shared) dsu.grow(variable_end);
     }
 
-    pcp::BinaryCSP new_BinaryCSP(new_size);
+    // Copy the i-th reduced PCP of the placed batch, powering the variables of ball, into its slot and merge the
+    // variables it shares with earlier balls. Different i may be written concurrently.
+    void write(size_t i, util::span<pcp::Variable> ball, const pcp::BinaryCSP &reduced_pcp) {
+        size_t offset = variable_offsets[i];
+        for (pcp::Variable j = 0; j < reduced_pcp.get_size(); ++j) {
+            variables[offset + j] = reduced_pcp.get_variable(j);
+        }
+        size_t edge = edge_offsets[i];
+        for (const auto &[u, v, c] : reduced_pcp.get_constraints_list()) {
+            edges[edge++] = std::make_tuple(u + offset, v + offset, c);
+        }
 
-    for (pcp::Variable i = 0; i < offsets.back(); ++i) {
-        if (dsu.find(i) == i) {
-            new_BinaryCSP.set_variable(
-                representative_map[i],
-                pcp.get_variable(i)
-            );
+        if (!merge_shared) return;
+        // the first 3 * ball.size() variables of a reduced PCP are the bits of its ball; every occurrence of v is
+        // merged into whichever ball claimed v first, the DSU roots each set at its smallest slot anyway
+        for (size_t k = 0; k < ball.size(); ++k) {
+            size_t slot = offset + k * pcp::BinaryDomainSize;
+            size_t owner = NOT_SEEN;
+            if (first_occurrence[ball[k]].compare_exchange_strong(owner, slot, std::memory_order_relaxed)) continue;
+            for (size_t bit = 0; bit < pcp::BinaryDomainSize; ++bit) {
+                dsu.merge(owner + bit, slot + bit);
+            }
         }
     }
 
-    for (const auto &[u, v, c] : pcp.get_constraints_list()) {
-        pcp::Variable new_u = representative_map[dsu.find(u)];
-        pcp::Variable new_v = representative_map[dsu.find(v)];
-        new_BinaryCSP.add_constraint(new_u, new_v, c);
+#ifndef SINGLE_THREAD
+
+    // Merge the shared variables and drop the ones without constraints, like merge_variables and clean did.
+    // Survivors are numbered by a parallel prefix sum over the used flags of the set representatives.
+    pcp::BinaryCSP finish(util::thread_pool &pool) && {
+        const size_t grain = 4096;
+        size_t total = variables.size();
+        std::vector<std::atomic<bool>> used(total);
+        pool.parallel_for(0, edges.size(), grain, [&](size_t first, size_t last) {
+            for (size_t e = first; e < last; ++e) {
+                auto &[u, v, c] = edges[e];
+                u = representative(u);
+                v = representative(v);
+                used[u].store(true, std::memory_order_relaxed);
+                used[v].store(true, std::memory_order_relaxed);
+            }
+        });
+        dsu = util::concurrent_disjoint_set_union();
+        first_occurrence = std::vector<std::atomic<size_t>>();
+
+        std::vector<pcp::Variable> label(total);
+        pool.parallel_for(0, total, grain, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                label[i] = used[i].load(std::memory_order_relaxed) ? 1 : 0;
+            }
+        });
+        size_t new_size = util::parallel_exclusive_scan(pool, label, grain);
+
+        std::vector<pcp::BinaryDomain> compacted(new_size);
+        pool.parallel_for(0, total, grain, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                if (used[i].load(std::memory_order_relaxed)) compacted[label[i]] = variables[i];
+            }
+        });
+        variables = std::vector<pcp::BinaryDomain>();
+        pool.parallel_for(0, edges.size(), grain, [&](size_t first, size_t last) {
+            for (size_t e = first; e < last; ++e) {
+                auto &[u, v, c] = edges[e];
+                u = label[u];
+                v = label[v];
+            }
+        });
+        return pcp::BinaryCSP(std::move(compacted), std::move(edges));
     }
-    pcp = std::move(new_BinaryCSP);
-}
 
-namespace core {
+#else
 
-#ifndef SINGLE_THREAD
+    // Merge the shared variables and drop the ones without constraints, like merge_variables and clean did
+    pcp::BinaryCSP finish() && {
+        size_t total = variables.size();
+        std::vector<bool> used(total, false);
+        for (auto &[u, v, c] : edges) {
+            u = representative(u);
+            v = representative(v);
+            used[u] = true;
+            used[v] = true;
+        }
+        dsu = util::concurrent_disjoint_set_union();
+        first_occurrence = std::vector<std::atomic<size_t>>();
+
+        // survivors keep the order of their representatives, compacted towards the front of the arena
+        std::vector<pcp::Variable> label(total);
+        size_t new_size = 0;
+        for (size_t i = 0; i < total; ++i) {
+            if (used[i]) {
+                label[i] = new_size;
+                variables[new_size++] = variables[i];
+            }
+        }
+        variables.resize(new_size);
+        variables.shrink_to_fit();
+        for (auto &[u, v, c] : edges) {
+            u = label[u];
+            v = label[v];
+        }
+        return pcp::BinaryCSP(std::move(variables), std::move(edges));
+    }
 
-namespace {
+#endif
+
+private:
+    static constexpr size_t NOT_SEEN = std::numeric_limits<size_t>::max();
 
-struct gap_amplification_task_result {
-    std::vector<pcp::Variable> neighbors;
-    pcp::BinaryCSP reduced_pcp;
+    pcp::Variable representative(pcp::Variable x) {
+        return merge_shared ? dsu.find(x) : x;
+    }
+
+    size_t original_size;
+    bool merge_shared;
+    size_t placed = 0;
+    // first_occurrence[v] is the arena slot of the first bit of v in the ball that claimed v first
+    std::vector<std::atomic<size_t>> first_occurrence;
+    util::concurrent_disjoint_set_union dsu;
+    // arena offsets of the variables and edges of every reduced PCP in the current batch
+    std::vector<size_t> variable_offsets;
+    std::vector<size_t> edge_offsets;
+    std::vector<pcp::BinaryDomain> variables;
+    std::vector<std::tuple<pcp::Variable, pcp::Variable, constraint::BinaryConstraint>> edges;
 };
 
 }
 
-pcp::BinaryCSP gap_amplification(pcp::BinaryCSP pcp, pcpp::TesterType tester_type) {
-    to_expander(pcp, constants::EXPANDING_COEFFICIENT);
-    pcp = reduce_degree(pcp, constants::DEGREE);
+#ifndef SINGLE_THREAD
+
+pcp::BinaryCSP gap_amplification(pcp::BinaryCSP pcp, pcpp::TesterType tester_type, std::uint64_t round) {
+    to_expander(pcp, constants::EXPANDING_COEFFICIENT, round);
+    // the degree reduced graph is only traversed from here on, so keep it in CSR form
+    const pcp::FrozenBinaryCSP reduced(reduce_degree(pcp, constants::DEGREE, round));
+    pcp = pcp::BinaryCSP();
 
     unsigned int num_threads = std::thread::hardware_concurrency();
     if (num_threads == 0) num_threads = constants::SAFE_THREAD_NUMBER;
 
-    size_t original_size = pcp.get_size();
-
-    std::vector<pcp::BinaryCSP> reduced_pcps(original_size);
-
-    std::vector<std::future<gap_amplification_task_result>> futures;
-    futures.reserve(original_size);
-
-    std::vector<std::vector<std::pair<pcp::Variable, size_t>>> occuring_location(original_size);
+    size_t original_size = reduced.get_size();
 
     util::thread_pool pool(num_threads);
 
-    for (pcp::Variable u = 0; u < static_cast<pcp::Variable>(original_size); ++u) {
-        futures.push_back(pool.enqueue([&pcp, tester_type, u]() {
-            std::vector<pcp::Variable> neighbors = pcp.get_neighbors(u, constants::POWERING_RADIUS);
-            pcp::BinaryCSP powering_u = pcp.build_sub_pcp(neighbors);
-
-            std::unique_ptr<pcpp::Tester> tester = pcpp::get_tester(tester_type);
-            tester->create_tester(powering_u);
-
-            return gap_amplification_task_result{
-                std::move(neighbors),
-                tester->buildBinaryCSP()
-            };
-        }));
-    }
-
-    for (pcp::Variable u = 0; u < static_cast<pcp::Variable>(futures.size()); ++u) {
-        gap_amplification_task_result task_result = futures[u].get();
-        for (size_t i = 0; i < task_result.neighbors.size(); ++i) {
-            occuring_location[task_result.neighbors[i]].emplace_back(u, i);
+    // for Hadamard tester, we can further merge variables that are not merged in the tester but are actually the same due to the structure of the powering PCPs
+    amplified_output output(original_size, tester_type == pcpp::TesterType::HADAMARD);
+
+    // workers power whole chunks of variables into the slots of one window; the previous window, already placed in
+    // the output, is written and merged by the same parallel_for, so merging overlaps with building testers and only
+    // two windows of reduced PCPs are alive at any time
+    static_assert(constants::POWERING_WINDOW_SIZE % constants::POWERING_CHUNK_SIZE == 0,
+        "a window must consist of whole chunks");
+    const size_t chunk_size = constants::POWERING_CHUNK_SIZE;
+    const size_t window_size = constants::POWERING_WINDOW_SIZE;
+    std::vector<std::vector<pcp::Neighborhoods>> balls(2, std::vector<pcp::Neighborhoods>(window_size / chunk_size));
+    std::vector<std::vector<pcp::BinaryCSP>> reduced_pcps(2, std::vector<pcp::BinaryCSP>(window_size));
+
+    size_t window_count = (original_size + window_size - 1) / window_size;
+    for (size_t window = 0; window <= window_count; ++window) {
+        size_t power_begin = std::min(original_size, window * window_size);
+        size_t power_end = std::min(original_size, power_begin + window_size);
+        size_t power_chunks = (power_end - power_begin + chunk_size - 1) / chunk_size;
+        std::vector<pcp::Neighborhoods> &power_balls = balls[window % 2];
+        std::vector<pcp::BinaryCSP> &power_pcps = reduced_pcps[window % 2];
+
+        size_t write_begin = window == 0 ? 0 : (window - 1) * window_size;
+        size_t write_end = power_begin;
+        size_t write_chunks = (write_end - write_begin + chunk_size - 1) / chunk_size;
+        std::vector<pcp::Neighborhoods> &write_balls = balls[(window + 1) % 2];
+        std::vector<pcp::BinaryCSP> &write_pcps = reduced_pcps[(window + 1) % 2];
+
+        auto power_chunk = [&](size_t chunk) {
+            size_t first = power_begin + chunk * chunk_size;
+            size_t last = std::min(power_end, first + chunk_size);
+            // every pool worker reuses its own BFS workspace and remap table across chunks
+            util::bfs_workspace &workspace = util::bfs_workspace::local();
+            pcp::Neighborhoods chunk_balls = reduced.all_neighborhoods(
+                constants::POWERING_RADIUS, static_cast<pcp::Variable>(first), static_cast<pcp::Variable>(last)
+            );
+            for (pcp::Variable u = first; u < static_cast<pcp::Variable>(last); ++u) {
+                pcp::BinaryCSP powering_u = reduced.build_sub_pcp(chunk_balls.get_ball(u), workspace);
+
+                std::unique_ptr<pcpp::Tester> tester = pcpp::get_tester(tester_type);
+                tester->create_tester(powering_u);
+                // keyed by u, so the tester is the same whichever worker powers u
+                util::philox rng = constants::random_stream(constants::RandomStage::TESTER, u, round);
+                power_pcps[u - power_begin] = tester->buildBinaryCSP(rng);
+            }
+            power_balls[chunk] = std::move(chunk_balls);
+        };
+
+        auto write_chunk = [&](size_t chunk) {
+            size_t first = write_begin + chunk * chunk_size;
+            size_t last = std::min(write_end, first + chunk_size);
+            for (size_t u = first; u < last; ++u) {
+                output.write(u - write_begin, write_balls[chunk].get_ball(static_cast<pcp::Variable>(u)), write_pcps[u - write_begin]);
+                write_pcps[u - write_begin] = pcp::BinaryCSP();
+            }
+        };
+
+        pool.parallel_for(0, power_chunks + write_chunks, 1, [&](size_t first, size_t last) {
+            for (size_t job = first; job < last; ++job) {
+                if (job < power_chunks) {
+                    power_chunk(job);
+                } else {
+                    write_chunk(job - power_chunks);
+                }
+            }
+        });
+
+        if (power_end > power_begin) {
+            output.place(util::span<pcp::BinaryCSP>(power_pcps.data(), power_end - power_begin));
         }
-        reduced_pcps[u] = std::move(task_result.reduced_pcp);
     }
 
-    pcp = pcp::merge_BinaryCSPs(reduced_pcps);
-
-    if (tester_type == pcpp::TesterType::HADAMARD) {
-        // for Hadamard tester, we can further merge variables that are not merged in the tester but are actually the same due to the structure of the powering PCPs
-        merge_variables(original_size, pcp, occuring_location, reduced_pcps);
-    }
-
-    pcp.clean();
-    return pcp;
+    return std::move(output).finish(pool);
 }
 
 #else
 
-pcp::BinaryCSP gap_amplification(pcp::BinaryCSP pcp, pcpp::TesterType tester_type) {
-    to_expander(pcp, constants::EXPANDING_COEFFICIENT);
-    pcp = reduce_degree(pcp, constants::DEGREE);
-    size_t original_size = pcp.get_size();
-    std::vector<std::vector<std::pair<pcp::Variable, size_t>>> occuring_location(original_size);
+pcp::BinaryCSP gap_amplification(pcp::BinaryCSP pcp, pcpp::TesterType tester_type, std::uint64_t round) {
+    to_expander(pcp, constants::EXPANDING_COEFFICIENT, round);
+    const pcp::FrozenBinaryCSP reduced(reduce_degree(pcp, constants::DEGREE, round));
+    pcp = pcp::BinaryCSP();
+    size_t original_size = reduced.get_size();
 
-    std::vector<pcp::BinaryCSP> reduced_pcps;
+    amplified_output output(original_size, true);
 
-    for (pcp::Variable u = 0; u < static_cast<pcp::Variable>(pcp.get_size()); ++u) {
-        std::vector<pcp::Variable> neighbors = pcp.get_neighbors(u, constants::POWERING_RADIUS);
-        for (size_t i = 0; i < neighbors.size(); ++i) {
-            occuring_location[neighbors[i]].emplace_back(u, i);
-        }
-        pcp::BinaryCSP powering_u = pcp.build_sub_pcp(neighbors);
+    for (pcp::Variable u = 0; u < static_cast<pcp::Variable>(original_size); ++u) {
+        std::vector<pcp::Variable> neighbors = reduced.get_neighbors(u, constants::POWERING_RADIUS);
+        pcp::BinaryCSP powering_u = reduced.build_sub_pcp(neighbors);
         std::unique_ptr<pcpp::Tester> tester = pcpp::get_tester(tester_type); tester->create_tester(powering_u);
-        pcp::BinaryCSP reduced_pcp = tester->buildBinaryCSP();
-        reduced_pcps.push_back(reduced_pcp);
+        util::philox rng = constants::random_stream(constants::RandomStage::TESTER, u, round);
+        pcp::BinaryCSP reduced_pcp = tester->buildBinaryCSP(rng);
+        output.place(util::span<pcp::BinaryCSP>(&reduced_pcp, 1));
+        output.write(0, neighbors, reduced_pcp);
     }
-    pcp = pcp::merge_BinaryCSPs(reduced_pcps);
 
-    merge_variables(original_size, pcp, occuring_location, reduced_pcps);
-    pcp.clean();
-    return pcp;
+    return std::move(output).finish();
 }
 
 #endif
 
-}
\ No newline at end of file
+}
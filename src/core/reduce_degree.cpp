@@ -6,7 +6,7 @@
 
 namespace core {
 
-pcp::BinaryCSP reduce_degree(const pcp::BinaryCSP &pcp, int degree) {
+pcp::BinaryCSP reduce_degree(const pcp::BinaryCSP &pcp, int degree, std::uint64_t round) {
     if (degree < 3) {
         throw std::invalid_argument("degree must be at least 3");
     }
@@ -42,7 +42,7 @@ pcp::BinaryCSP reduce_degree(const pcp::BinaryCSP &pcp, int degree) {
             reduced_pcp.add_constraint(curr, adj_new_index, con);
         }
         // random edge picker for picking random edges to connect local expander
-        util::random_picker<pcp::Variable> rp;
+        util::random_picker<pcp::Variable> rp(constants::random_stream(constants::RandomStage::DEGREE_REDUCTION, i, round));
         for (size_t j = 0; j < sizes[i]; ++j) {
             size_t curr = offsets[i] + j;
             rp.add(curr, degree - reduced_pcp.get_constraints(curr).size());
@@ -14,7 +14,7 @@ pcp::BinaryCSP three_color_gap_amplification(const three_color::ThreeColor &tc,
     iterations = std::max(iterations, 0);
     for (int i = 0; i < iterations; ++i) {
         std::cout << "Gap amplification iteration " << (i + 1) << " / " << iterations << ' ' << pcp.get_size() << ' ' << pcp.get_constraints_list().size() << std::endl;
-        pcp = gap_amplification(pcp, tester_type);
+        pcp = gap_amplification(pcp, tester_type, i);
     }
     return pcp;
 }
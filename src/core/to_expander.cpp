@@ -9,7 +9,7 @@
 
 namespace core {
 
-pcp::BinaryCSP& to_expander(pcp::BinaryCSP &pcp, int expanding_coefficient) {
+pcp::BinaryCSP& to_expander(pcp::BinaryCSP &pcp, int expanding_coefficient, std::uint64_t round) {
     // generate random seed
     if (pcp.get_size() <= 1) {
         return pcp; // cannot expand
@@ -23,9 +23,8 @@ pcp::BinaryCSP& to_expander(pcp::BinaryCSP &pcp, int expanding_coefficient) {
 
     for (pcp::Variable i = 0; i < static_cast<pcp::Variable>(pcp.get_size()); ++i) {
         pcp::Variable j = (i + 1) % pcp.get_size();
-        if (!dsu.same_set(i, j)) {
+        if (dsu.merge(i, j)) {
             pcp.add_constraint(i, j, constraint::BinaryConstraint::ANY);
-            dsu.merge(i, j);
         }
     }
 
@@ -36,8 +35,9 @@ pcp::BinaryCSP& to_expander(pcp::BinaryCSP &pcp, int expanding_coefficient) {
     std::vector<int> options(pcp.get_size());
     std::iota(options.begin(), options.end(), 0);
     for (size_t i = 0; i < pcp.get_size(); ++i) {
+        util::philox rng = constants::random_stream(constants::RandomStage::EXPANDER, i, round);
         for (int j = 0; j < expanding_coefficient; ++j) {
-            int target = dist(constants::RANDOM_SEED);
+            int target = dist(rng);
             pcp.add_constraint(i, target, constraint::BinaryConstraint::ANY);
         }
         // swap current node to front to avoid self-loop
@@ -1,7 +1,6 @@
 #include <cstdint>
-#include <queue>
+#include <limits>
 #include <stdexcept>
-#include <unordered_set>
 #include <string>
 
 #include "pcp/BinaryCSP.hpp"
@@ -9,24 +8,38 @@
 
 namespace pcp {
 
+namespace {
+
+// every variable of a BinaryCSP must be addressable by the configured Variable width
+size_t checked_size(size_t size) {
+    if constexpr (sizeof(Variable) < sizeof(size_t)) {
+        if (size > static_cast<size_t>(std::numeric_limits<Variable>::max())) {
+            throw std::length_error("BinaryCSP: size exceeds the range of pcp::Variable, rebuild with a wider PCP_VARIABLE_BITS");
+        }
+    }
+    return size;
+}
+
+}
+
 // BinaryCSP class implementation
 // Constructors
 BinaryCSP::BinaryCSP() : BinaryCSP(0) {}
 
 BinaryCSP::BinaryCSP(size_t size)
- : size(size), 
+ : size(checked_size(size)), 
    variables(size, false), 
    constraints(size), 
    constraint_indices(size) {}
 
 BinaryCSP::BinaryCSP(const std::vector<BinaryDomain> &variables)
- : size(variables.size()), 
+ : size(checked_size(variables.size())), 
    variables(variables), 
    constraints(variables.size()), 
    constraint_indices(variables.size()) {}
 
 BinaryCSP::BinaryCSP(std::vector<BinaryDomain> &&variables)
- : size(variables.size()), 
+ : size(checked_size(variables.size())), 
    variables(std::move(variables)), 
    constraints(size), 
    constraint_indices(size) {}
@@ -34,16 +47,43 @@ BinaryCSP::BinaryCSP(std::vector<BinaryDomain> &&variables)
 BinaryCSP::BinaryCSP(std::vector<BinaryDomain> &&variables,
     const std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> &constraints_list)
  : BinaryCSP(std::move(variables)) {
-    for (const auto& [u, v, c] : constraints_list) {
-        add_constraint(u, v, c);
-    }
+    add_constraints(constraints_list);
 }
 
 BinaryCSP::BinaryCSP(std::vector<BinaryDomain> &&variables,
     std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> &&constraints_list)
  : BinaryCSP(std::move(variables)) {
-    for (const auto& [u, v, c] : constraints_list) {
-        add_constraint(u, v, c);
+    add_constraints(constraints_list);
+}
+
+void BinaryCSP::add_constraints(const std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> &edges) {
+    // validate and count degrees first so every adjacency list is allocated exactly once
+    std::vector<Index> degree(size, 0);
+    for (const auto& [u, v, c] : edges) {
+        if (u >= static_cast<Variable>(size) || v >= static_cast<Variable>(size)) {
+            throw std::out_of_range("BinaryCSP::add_constraint: index out of range");
+        }
+        ++degree[u];
+        ++degree[v];
+    }
+    std::vector<Index> cursor(size);
+    for (size_t i = 0; i < size; ++i) {
+        cursor[i] = constraints[i].size();
+        constraints[i].resize(cursor[i] + degree[i]);
+        constraint_indices[i].resize(cursor[i] + degree[i]);
+    }
+    constraints_list.reserve(constraints_list.size() + edges.size());
+
+    // same layout add_constraint produces edge by edge
+    for (const auto& [u, v, c] : edges) {
+        Index in_u = cursor[u]++;
+        Index in_v = cursor[v]++;
+        constraints[u][in_u] = {v, c};
+        constraints[v][in_v] = {u, c};
+        constraint_indices[u][in_u] = {v, in_v};
+        // add_constraint records the last slot of a self-loop for both of its entries
+        constraint_indices[v][in_v] = {u, u == v ? in_v : in_u};
+        constraints_list.emplace_back(u, v, c);
     }
 }
 
@@ -52,9 +92,12 @@ size_t BinaryCSP::get_size() const { return size; }
 
 BinaryDomain BinaryCSP::get_variable(Variable var) const { return variables[var]; }
 
+const std::vector<BinaryDomain>& BinaryCSP::get_variables() const { return variables; }
+
 void BinaryCSP::set_variable(Variable var, BinaryDomain value) { variables[var] = value; }
 
 void BinaryCSP::add_variable(BinaryDomain value) {
+    checked_size(size + 1);
     variables.push_back(value);
     constraints.emplace_back();
     constraint_indices.emplace_back();
@@ -86,60 +129,67 @@ void BinaryCSP::add_constraint(Variable var, Variable other_var, constraint::Bin
 }
 
 std::vector<Variable> BinaryCSP::get_neighbors(Variable var, int radius) const {
-    std::vector<Variable> neighbors;
-    std::unordered_set<Variable> visited;
-    std::queue<std::pair<Variable, int>> q; // pair of (node, current_depth)
-    q.emplace(var, 0);
-    visited.insert(var);
-
-    while (!q.empty()) {
-        auto [current, depth] = q.front();
-        q.pop();
-        neighbors.push_back(current);
-        if (depth < radius) {
-            for (const auto &[neighbor, _] : constraints[current]) {
-                if (visited.find(neighbor) == visited.end()) {
-                    visited.insert(neighbor);
-                    q.emplace(neighbor, depth + 1);
-                }
-            }
-        }
-    }
+    return get_neighbors(var, radius, util::bfs_workspace::local());
+}
 
+std::vector<Variable> BinaryCSP::get_neighbors(Variable var, int radius, util::bfs_workspace &workspace) const {
+    std::vector<Variable> neighbors;
+    workspace.collect_ball(*this, var, radius, neighbors);
     return neighbors;
 }
 
+Neighborhoods BinaryCSP::all_neighborhoods(int radius) const {
+    return all_neighborhoods(radius, 0, static_cast<Variable>(get_size()));
+}
+
+Neighborhoods BinaryCSP::all_neighborhoods(int radius, Variable first, Variable last) const {
+    return collect_neighborhoods(*this, radius, first, last, util::bfs_workspace::local());
+}
+
 BinaryCSP BinaryCSP::get_neighboring_pcp(Variable var, int radius) const {
     std::vector<Variable> neighbors = get_neighbors(var, radius);
     return build_sub_pcp(neighbors);
 }
 
-BinaryCSP BinaryCSP::build_sub_pcp(const std::vector<Variable> &neighbors) const  {
-    std::unordered_map<Variable, Variable> index_map; // original index to new index
+BinaryCSP BinaryCSP::build_sub_pcp(util::span<Variable> neighbors) const {
+    return build_sub_pcp(neighbors, util::bfs_workspace::local());
+}
 
-    BinaryCSP neighboring_pcp(neighbors.size());
-    // Copy variables
+BinaryCSP BinaryCSP::build_sub_pcp(util::span<Variable> neighbors, util::bfs_workspace &workspace) const {
+    // dense original index to new index table, reset in O(1) by the workspace epoch
+    workspace.start(size);
+    std::vector<BinaryDomain> sub_variables;
+    sub_variables.reserve(neighbors.size());
     for (size_t i = 0; i < neighbors.size(); ++i) {
-        neighboring_pcp.set_variable(static_cast<Variable>(i), get_variable(neighbors[i]));
-        index_map[neighbors[i]] = static_cast<Variable>(i);
+        sub_variables.push_back(variables[neighbors[i]]);
+        workspace.map(neighbors[i], static_cast<Variable>(i));
     }
-    // Copy constraints
-    for (size_t i = 0; i < neighbors.size(); ++i) {
-        Variable u = neighbors[i];
+
+    // count the internal constraints so the edge buffer is allocated once
+    size_t edge_count = 0;
+    for (Variable u : neighbors) {
         for (const auto &[v, constraint] : constraints[u]) {
-            if (index_map.find(v) != index_map.end()) {
-                if (constraint != constraint::BinaryConstraint::ANY) {
-                    neighboring_pcp.add_constraint(
-                        static_cast<Variable>(i), 
-                        index_map[v], 
-                        constraint
-                    );
-                }
+            if (constraint != constraint::BinaryConstraint::ANY
+                && workspace.lookup(v) != util::bfs_workspace::NOT_MAPPED) {
+                ++edge_count;
+            }
+        }
+    }
+
+    // every internal constraint is seen from both ends, so it is emitted twice like before
+    std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> edges;
+    edges.reserve(edge_count);
+    for (size_t i = 0; i < neighbors.size(); ++i) {
+        for (const auto &[v, constraint] : constraints[neighbors[i]]) {
+            if (constraint == constraint::BinaryConstraint::ANY) continue;
+            Variable local = workspace.lookup(v);
+            if (local != util::bfs_workspace::NOT_MAPPED) {
+                edges.emplace_back(static_cast<Variable>(i), local, constraint);
             }
         }
     }
 
-    return neighboring_pcp;
+    return BinaryCSP(std::move(sub_variables), std::move(edges));
 }
 
 void BinaryCSP::clean() {
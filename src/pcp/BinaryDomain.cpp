@@ -2,40 +2,35 @@
 
 namespace pcp {
 
-BinaryDomain::BinaryDomain() : bits(0), domain_type(three_csp::Constraint::ANY) {}
+namespace {
+
+std::uint8_t pack(int value, three_csp::Constraint domain_type) {
+    return static_cast<std::uint8_t>((value & BinaryDomain::VALUE_MASK) 
+        | (static_cast<int>(domain_type) << BinaryDomain::VALUE_BITS));
+}
+
+}
+
+BinaryDomain::BinaryDomain() : packed(pack(0, three_csp::Constraint::ANY)) {}
 
 BinaryDomain::BinaryDomain(int value) 
- : bits(value), domain_type(three_csp::Constraint::ANY) {}
+ : packed(pack(value, three_csp::Constraint::ANY)) {}
 
 BinaryDomain::BinaryDomain(int value, three_csp::Constraint domain_type)
- : bits(value), domain_type(domain_type) {}
+ : packed(pack(value, domain_type)) {}
 
 
 BinaryDomain::BinaryDomain(bool bit0, bool bit1, bool bit2, three_csp::Constraint domain_type)
- : bits(0), domain_type(domain_type) {
-    bits[0] = bit0;
-    bits[1] = bit1;
-    bits[2] = bit2;
-}
+ : packed(pack(bit0 | (bit1 << 1) | (bit2 << 2), domain_type)) {}
 
-bool BinaryDomain::operator==(const BinaryDomain &other) const {
-    return bits == other.bits && domain_type == other.domain_type;
-}
-
-bool BinaryDomain::operator!=(const BinaryDomain &other) const {
-    return !(*this == other);
-}
-
-bool BinaryDomain::operator[](size_t index) const {
-    return bits[index];
+void BinaryDomain::set_domain_type(three_csp::Constraint new_domain_type) {
+    packed = pack(get_value(), new_domain_type);
 }
 
-three_csp::Constraint BinaryDomain::get_domain_type() const {
-    return domain_type;
+BinaryDomain BinaryDomain::from_packed(std::uint8_t packed) {
+    BinaryDomain result;
+    result.packed = packed;
+    return result;
 }
 
-void BinaryDomain::set_domain_type(three_csp::Constraint new_domain_type) {
-    domain_type = new_domain_type;
 }
-
-}
\ No newline at end of file
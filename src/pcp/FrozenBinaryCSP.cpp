@@ -0,0 +1,144 @@
+#include <stdexcept>
+
+#include "pcp/FrozenBinaryCSP.hpp"
+
+namespace pcp {
+
+// FrozenBinaryCSP class implementation
+// Constructors
+FrozenBinaryCSP::FrozenBinaryCSP() : offsets(1, 0) {}
+
+FrozenBinaryCSP::FrozenBinaryCSP(const BinaryCSP &pcp)
+ : variables(pcp.variables),
+   constraints_list(pcp.constraints_list) {
+    build_adjacency();
+}
+
+FrozenBinaryCSP::FrozenBinaryCSP(BinaryCSP &&pcp)
+ : variables(std::move(pcp.variables)),
+   constraints_list(std::move(pcp.constraints_list)) {
+    pcp = BinaryCSP();
+    build_adjacency();
+}
+
+FrozenBinaryCSP::FrozenBinaryCSP(std::vector<BinaryDomain> &&variables,
+    std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> &&constraints_list)
+ : variables(std::move(variables)),
+   constraints_list(std::move(constraints_list)) {
+    build_adjacency();
+}
+
+void FrozenBinaryCSP::build_adjacency() {
+    size_t size = variables.size();
+    // count the degree of every variable
+    offsets.assign(size + 1, 0);
+    for (const auto &[u, v, c] : constraints_list) {
+        if (u >= static_cast<Variable>(size) || v >= static_cast<Variable>(size)) {
+            throw std::out_of_range("FrozenBinaryCSP: constraint index out of range");
+        }
+        ++offsets[u + 1];
+        ++offsets[v + 1];
+    }
+    for (size_t i = 0; i < size; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    // scatter the edges in list order so every row keeps the order BinaryCSP::add_constraint produces
+    neighbors.resize(offsets.back());
+    constraint_types.resize(offsets.back());
+    std::vector<Index> cursor(offsets.begin(), offsets.end() - 1);
+    for (const auto &[u, v, c] : constraints_list) {
+        neighbors[cursor[u]] = v;
+        constraint_types[cursor[u]++] = c;
+        neighbors[cursor[v]] = u;
+        constraint_types[cursor[v]++] = c;
+    }
+}
+
+// Member functions
+size_t FrozenBinaryCSP::get_size() const { return variables.size(); }
+
+BinaryDomain FrozenBinaryCSP::get_variable(Variable var) const { return variables[var]; }
+
+void FrozenBinaryCSP::set_variable(Variable var, BinaryDomain value) { variables[var] = value; }
+
+const std::vector<BinaryDomain>& FrozenBinaryCSP::get_variables() const { return variables; }
+
+ConstraintView FrozenBinaryCSP::get_constraints(Variable var) const {
+    Index begin = offsets[var];
+    return ConstraintView(neighbors.data() + begin, constraint_types.data() + begin, offsets[var + 1] - begin);
+}
+
+const std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>>& FrozenBinaryCSP::get_constraints_list() const {
+    return constraints_list;
+}
+
+std::vector<Variable> FrozenBinaryCSP::get_neighbors(Variable var, int radius) const {
+    return get_neighbors(var, radius, util::bfs_workspace::local());
+}
+
+std::vector<Variable> FrozenBinaryCSP::get_neighbors(Variable var, int radius, util::bfs_workspace &workspace) const {
+    std::vector<Variable> result;
+    workspace.collect_ball(*this, var, radius, result);
+    return result;
+}
+
+Neighborhoods FrozenBinaryCSP::all_neighborhoods(int radius) const {
+    return all_neighborhoods(radius, 0, static_cast<Variable>(get_size()));
+}
+
+Neighborhoods FrozenBinaryCSP::all_neighborhoods(int radius, Variable first, Variable last) const {
+    return collect_neighborhoods(*this, radius, first, last, util::bfs_workspace::local());
+}
+
+BinaryCSP FrozenBinaryCSP::get_neighboring_pcp(Variable var, int radius) const {
+    return build_sub_pcp(get_neighbors(var, radius));
+}
+
+BinaryCSP FrozenBinaryCSP::build_sub_pcp(util::span<Variable> ball) const {
+    return build_sub_pcp(ball, util::bfs_workspace::local());
+}
+
+BinaryCSP FrozenBinaryCSP::build_sub_pcp(util::span<Variable> ball, util::bfs_workspace &workspace) const {
+    // dense original index to new index table, reset in O(1) by the workspace epoch
+    workspace.start(variables.size());
+    std::vector<BinaryDomain> sub_variables;
+    sub_variables.reserve(ball.size());
+    for (size_t i = 0; i < ball.size(); ++i) {
+        sub_variables.push_back(variables[ball[i]]);
+        workspace.map(ball[i], static_cast<Variable>(i));
+    }
+
+    // count the internal constraints so the edge buffer is allocated once
+    size_t edge_count = 0;
+    for (Variable u : ball) {
+        for (Index j = offsets[u]; j < offsets[u + 1]; ++j) {
+            if (constraint_types[j] != constraint::BinaryConstraint::ANY
+                && workspace.lookup(neighbors[j]) != util::bfs_workspace::NOT_MAPPED) {
+                ++edge_count;
+            }
+        }
+    }
+
+    // every internal constraint is seen from both ends, so it is emitted twice like BinaryCSP::build_sub_pcp
+    std::vector<std::tuple<Variable, Variable, constraint::BinaryConstraint>> edges;
+    edges.reserve(edge_count);
+    for (size_t i = 0; i < ball.size(); ++i) {
+        Variable u = ball[i];
+        for (Index j = offsets[u]; j < offsets[u + 1]; ++j) {
+            if (constraint_types[j] == constraint::BinaryConstraint::ANY) continue;
+            Variable local = workspace.lookup(neighbors[j]);
+            if (local != util::bfs_workspace::NOT_MAPPED) {
+                edges.emplace_back(static_cast<Variable>(i), local, constraint_types[j]);
+            }
+        }
+    }
+
+    return BinaryCSP(std::move(sub_variables), std::move(edges));
+}
+
+BinaryCSP FrozenBinaryCSP::thaw() const {
+    return BinaryCSP(std::vector<BinaryDomain>(variables), constraints_list);
+}
+
+}
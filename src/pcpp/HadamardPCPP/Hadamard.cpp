@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <stdexcept>
 
 #include "Aliases.hpp"
@@ -10,32 +11,72 @@ Hadamard::Hadamard() {}
 
 Hadamard::Hadamard(const std::vector<bool> value) : value(value) {}
 
-bool Hadamard::query(const std::vector<bool> &idx) const {
-    bool code = false;
-    for (size_t i = 0; i < value.size(); ++i) {
-        code = (idx[i] & value[i]) ? (!code) : code;
+bool Hadamard::query(const Position &idx) const {
+    // the parity of the AND of every word pair adds up to the parity of their XOR
+    Position::Word parity = 0;
+    const std::vector<Position::Word> &value_words = value.get_words();
+    const std::vector<Position::Word> &idx_words = idx.get_words();
+    for (size_t w = 0; w < value_words.size(); ++w) {
+        parity ^= value_words[w] & idx_words[w];
     }
-    return code;
+    return __builtin_parityll(parity);
+}
+
+bool Hadamard::query(const std::vector<bool> &idx) const {
+    return query(Position(idx));
 }
 
 bool Hadamard::query(std::vector<bool> &&idx) const {
-    bool code = false;
-    for (size_t i = 0; i < value.size(); ++i) {
-        code = (idx[i] & value[i]) ? (!code) : code;
+    return query(Position(idx));
+}
+
+// throws if the 2^n entries of the codeword cannot be indexed
+static size_t code_length(size_t bits) {
+    if (bits >= sizeof(size_t) * 8) {
+        throw std::length_error("Hadamard: codeword is too long");
     }
-    return code;
+    return size_t(1) << bits;
 }
 
 std::vector<bool> Hadamard::getCode() const {
-    std::vector<bool> code(constants::PCPVARIABLE_ONE << value.size());
-    for (size_t i = 0; i < code.size(); ++i) {
-        std::vector<bool> idx(value.size());
-        for (size_t j = 0; j < value.size(); ++j) {
-            idx[j] = (i >> j) & 1;
-        }
-        code[i] = query(idx);
+    std::vector<bool> code(code_length(value.size()));
+    // the i-th Gray code differs from the previous one in bit ctz(i)
+    bool parity = false;
+    size_t gray = 0;
+    for (size_t i = 1; i < code.size(); ++i) {
+        size_t bit = __builtin_ctzll(i);
+        gray ^= size_t(1) << bit;
+        parity ^= value.get(bit);
+        code[gray] = parity;
     }
     return code;
 }
 
-}
\ No newline at end of file
+Position Hadamard::getPackedCode() const {
+    // entry x of the word pattern for index bit j, x = 0..63
+    static constexpr Position::Word PATTERNS[6] = {
+        0xaaaaaaaaaaaaaaaaull, 0xccccccccccccccccull, 0xf0f0f0f0f0f0f0f0ull,
+        0xff00ff00ff00ff00ull, 0xffff0000ffff0000ull, 0xffffffff00000000ull,
+    };
+    size_t length = code_length(value.size());
+    size_t low_bits = std::min<size_t>(value.size(), 6);
+    Position::Word first = 0;
+    for (size_t j = 0; j < low_bits; ++j) {
+        if (value.get(j)) first ^= PATTERNS[j];
+    }
+    if (length < Position::WORD_BITS) {
+        first &= (Position::Word(1) << length) - 1;
+    }
+
+    std::vector<Position::Word> words((length + Position::WORD_BITS - 1) / Position::WORD_BITS);
+    words[0] = first;
+    for (size_t j = 6, half = 1; j < value.size(); ++j, half *= 2) {
+        Position::Word flip = value.get(j) ? ~Position::Word(0) : 0;
+        for (size_t w = 0; w < half; ++w) {
+            words[half + w] = words[w] ^ flip;
+        }
+    }
+    return Position(length, std::move(words));
+}
+
+}
@@ -1,5 +1,9 @@
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <random>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 
 #include <cassert>
@@ -9,12 +13,12 @@
 #include "Aliases.hpp"
 #include "three_color/ThreeColor.hpp"
 #include "util/disjoint_set_union.hpp"
+#include "util/thread_pool.hpp"
 
 void merge_variables(
-    std::vector<three_color::Color> colors,
+    const std::vector<three_color::Color> &colors,
     pcp::BinaryCSP &pcp, 
-    const std::vector<std::vector<std::pair<size_t, int>>> &occuring_location,
-    const std::vector<pcp::BinaryCSP> &reduced_pcps
+    const std::vector<std::vector<std::pair<size_t, int>>> &occuring_location
 ) {
 
     util::disjoint_set_union dsu(pcp.get_size());
@@ -53,29 +57,19 @@ void merge_variables(
         }
     }
     
-    std::unordered_map<pcp::Variable, pcp::Variable> representative_map;
-    size_t new_size = 0;
-    for (pcp::Variable i = 0; i < pcp.get_size(); ++i) {
-        if (dsu.find(i) == i) {
-            representative_map[i] = new_size++;
-        }
-    }
-
-    pcp::BinaryCSP new_BinaryCSP(new_size);
+    // merged variables are numbered in order of their first member and keep its value
+    std::vector<std::uint32_t> labels = dsu.compress_all();
+    pcp::BinaryCSP new_BinaryCSP(dsu.get_set_count());
 
+    size_t new_size = 0;
     for (pcp::Variable i = 0; i < pcp.get_size(); ++i) {
-        if (dsu.find(i) == i) {
-            new_BinaryCSP.set_variable(
-                representative_map[i],
-                pcp.get_variable(i)
-            );
+        if (labels[i] == new_size) {
+            new_BinaryCSP.set_variable(new_size++, pcp.get_variable(i));
         }
     }
 
     for (const auto &[u, v, c] : pcp.get_constraints_list()) {
-        pcp::Variable new_u = representative_map[dsu.find(u)];
-        pcp::Variable new_v = representative_map[dsu.find(v)];
-        new_BinaryCSP.add_constraint(new_u, new_v, c);
+        new_BinaryCSP.add_constraint(labels[u], labels[v], c);
     }
     pcp = std::move(new_BinaryCSP);
 }
@@ -118,10 +112,9 @@ HadamardTester::HadamardTester(three_color::Color u, three_color::Color v) {
 #endif
     hadamard = Hadamard(three_csp.get_assignment());
 
-    constraint_matrix = std::vector<std::vector<bool>>{
-        // the local assignment u and v have different colors
-        {0, 1, 1, 1, 1, 1, 1, 1, 1},
-    };
+    // the local assignment u and v have different colors
+    constraint_matrix = ConstraintMatrix(three_csp.size());
+    constraint_matrix.add_row(Position(std::vector<bool>{0, 1, 1, 1, 1, 1, 1, 1, 1}));
 }
 
 // Construct HadamardTester from a BinaryCSP
@@ -153,73 +146,147 @@ HadamardTester::HadamardTester(const pcp::BinaryCSP &pcp) {
     three_csp.add_binary_constraint(0, three_csp.size() - 1, constraint::BinaryConstraint::NOTEQUAL);
     hadamard = Hadamard(three_csp.get_assignment());
     // Build constraint matrix from BinaryCSP constraints
+    constraint_matrix = ConstraintMatrix(three_csp.size());
     for (const auto &[var1, var2, bit_constraint] : pcp.get_constraints_list()) {
         if (bit_constraint != constraint::BinaryConstraint::ANY) {
-            std::vector<bool> row(three_csp.size());
+            // index of the first bit of each variable in three_csp
+            size_t base1 = static_cast<size_t>(var1) * 3;
+            size_t base2 = static_cast<size_t>(var2) * 3;
+            std::vector<size_t> row;
             switch (bit_constraint) {
                 case constraint::BinaryConstraint::EQUAL:
-                    row[var1 * 3] = 1;
-                    row[var1 * 3 + 1] = 1;
-                    row[var1 * 3 + 2] = 1;
-                    row[var2 * 3] = 1;
-                    row[var2 * 3 + 1] = 1;
-                    row[var2 * 3 + 2] = 1;
+                    row = {base1, base1 + 1, base1 + 2, base2, base2 + 1, base2 + 2};
                     break;
                 case constraint::BinaryConstraint::FIRST_BIT_EQUAL:
-                    row[var1 * 3] = 1;
-                    row[var2 * 3] = 1;
+                    row = {base1, base2};
                     break;
                 case constraint::BinaryConstraint::SECOND_BIT_EQUAL:
-                    row[var1 * 3 + 1] = 1;
-                    row[var2 * 3 + 1] = 1;
+                    row = {base1 + 1, base2 + 1};
                     break;
                 case constraint::BinaryConstraint::THIRD_BIT_EQUAL:
-                    row[var1 * 3 + 2] = 1;
-                    row[var2 * 3 + 2] = 1;
+                    row = {base1 + 2, base2 + 2};
                     break;
                 // Note that NOTEQUAL constraint is only added between three bit encoded of 0 and 1, meaning all three bits must be different to qualify as NOTEQUAL
-                case constraint::BinaryConstraint::NOTEQUAL:
-                    row[var1 * 3] = 1;
-                    row[var1 * 3 + 1] = 1;
-                    row[var1 * 3 + 2] = 1;
-                    row[var2 * 3] = 1;
-                    row[var2 * 3 + 1] = 1;
-                    row[var2 * 3 + 2] = 1;
-                    row[0] = !row[0]; 
-                    row.back() = 1; // negation bit
+                case constraint::BinaryConstraint::NOTEQUAL: {
+                    row = {base1, base1 + 1, base1 + 2, base2, base2 + 1, base2 + 2};
+                    std::sort(row.begin(), row.end());
+                    row.erase(std::unique(row.begin(), row.end()), row.end());
+                    // flip the first bit and set the negation bit
+                    auto first_bit = std::find(row.begin(), row.end(), 0);
+                    if (first_bit != row.end()) {
+                        row.erase(first_bit);
+                    } else {
+                        row.push_back(0);
+                    }
+                    row.push_back(three_csp.size() - 1);
                     break;
+                }
                 case constraint::BinaryConstraint::ANY:
                     // impossible case
                     break;
             }
-            constraint_matrix.push_back(std::move(row));
+            constraint_matrix.add_row(std::move(row));
         }
     }
 }
 
 pcp::BinaryCSP HadamardTester::three_color_to_BinaryCSP(const three_color::ThreeColor &tc) { 
-    std::vector<pcp::BinaryCSP> edge_pcps;
-    size_t variable_count = 0;
-    std::vector<std::vector<std::pair<size_t, int>>> occuring_locations(tc.get_colors().size());
-    for (three_color::Node u = 0; u < tc.get_colors().size(); ++u) {
+    const std::vector<three_color::Color> &colors = tc.get_colors();
+    std::vector<three_color::Edge> edges;
+    for (three_color::Node u = 0; u < colors.size(); ++u) {
         for (three_color::Node v : tc.get_adj_list()[u]) if (v > u) {
-            HadamardTester tester(tc.get_colors()[u], tc.get_colors()[v]);
-            pcp::BinaryCSP tmp = tester.buildBinaryCSP();
-            // reduce unnecessary variables
-            edge_pcps.push_back(std::move(tmp));
-            occuring_locations[u].emplace_back(variable_count, 0);
-            occuring_locations[v].emplace_back(variable_count, 1);
-            variable_count += edge_pcps.back().get_size();
+            edges.emplace_back(u, v);
+        }
+    }
+
+#ifndef SINGLE_THREAD
+    unsigned int num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = constants::SAFE_THREAD_NUMBER;
+    util::thread_pool pool(num_threads);
+    auto for_each_edge = [&](size_t grain, auto &&body) { pool.parallel_for(0, edges.size(), grain, body); };
+#else
+    auto for_each_edge = [&](size_t, auto &&body) { body(size_t(0), edges.size()); };
+#endif
+
+    std::vector<pcp::BinaryCSP> gadgets;
+    std::vector<const pcp::BinaryCSP*> chosen(edges.size());
+    if (gadget_templates > 0) {
+        // gadgets for the ordered color pair (a, b) are gadgets[(a * 3 + b) * gadget_templates + k]
+        const size_t color_count = 3;
+        gadgets.reserve(color_count * color_count * gadget_templates);
+        for (size_t a = 0; a < color_count; ++a) {
+            for (size_t b = 0; b < color_count; ++b) {
+                for (size_t k = 0; k < gadget_templates; ++k) {
+                    HadamardTester tester(static_cast<three_color::Color>(a), static_cast<three_color::Color>(b));
+                    util::philox rng = constants::random_stream(constants::RandomStage::GADGET_TEMPLATE, gadgets.size());
+                    gadgets.push_back(tester.buildBinaryCSP(rng));
+                }
+            }
+        }
+        std::uniform_int_distribution<size_t> pick(0, gadget_templates - 1);
+        for (size_t e = 0; e < edges.size(); ++e) {
+            size_t pair = static_cast<size_t>(colors[edges[e].first]) * color_count + static_cast<size_t>(colors[edges[e].second]);
+            util::philox rng = constants::random_stream(constants::RandomStage::EDGE_GADGET, e);
+            chosen[e] = &gadgets[pair * gadget_templates + pick(rng)];
+        }
+    } else {
+        // every edge draws from its own stream, so the gadgets do not depend on which thread builds them or in which order
+        gadgets.resize(edges.size());
+        for_each_edge(constants::GADGET_BUILD_CHUNK_SIZE, [&](size_t first, size_t last) {
+            for (size_t e = first; e < last; ++e) {
+                util::philox rng = constants::random_stream(constants::RandomStage::EDGE_GADGET, e);
+                HadamardTester tester(colors[edges[e].first], colors[edges[e].second]);
+                gadgets[e] = tester.buildBinaryCSP(rng);
+            }
+        });
+        for (size_t e = 0; e < edges.size(); ++e) {
+            chosen[e] = &gadgets[e];
         }
     }
-    auto result = pcp::merge_BinaryCSPs(edge_pcps);
-    merge_variables(tc.get_colors(), result, occuring_locations, edge_pcps);
+
+    // lay the gadgets out back to back; u's bits sit at position 0 of its edges' gadgets and v's at position 1
+    std::vector<size_t> variable_offsets(edges.size() + 1, 0);
+    std::vector<size_t> edge_offsets(edges.size() + 1, 0);
+    std::vector<std::vector<std::pair<size_t, int>>> occuring_locations(colors.size());
+    for (size_t e = 0; e < edges.size(); ++e) {
+        occuring_locations[edges[e].first].emplace_back(variable_offsets[e], 0);
+        occuring_locations[edges[e].second].emplace_back(variable_offsets[e], 1);
+        variable_offsets[e + 1] = variable_offsets[e] + chosen[e]->get_size();
+        edge_offsets[e + 1] = edge_offsets[e] + chosen[e]->get_constraints_list().size();
+    }
+
+    std::vector<pcp::BinaryDomain> variables(variable_offsets.back());
+    std::vector<std::tuple<pcp::Variable, pcp::Variable, constraint::BinaryConstraint>> constraints(edge_offsets.back());
+    // every edge writes its own disjoint slice of the output
+    for_each_edge(constants::GADGET_STAMP_CHUNK_SIZE, [&](size_t first, size_t last) {
+        for (size_t e = first; e < last; ++e) {
+            const pcp::BinaryCSP &gadget = *chosen[e];
+            size_t offset = variable_offsets[e];
+            for (pcp::Variable i = 0; i < static_cast<pcp::Variable>(gadget.get_size()); ++i) {
+                variables[offset + static_cast<size_t>(i)] = gadget.get_variable(i);
+            }
+            auto out = constraints.begin() + edge_offsets[e];
+            for (const auto &[x, y, c] : gadget.get_constraints_list()) {
+                *out++ = {x + offset, y + offset, c};
+            }
+        }
+    });
+    gadgets.clear();
+
+    pcp::BinaryCSP result(std::move(variables), std::move(constraints));
+    merge_variables(colors, result, occuring_locations);
     result.clean();
     return result;
 }
 
+void HadamardTester::set_gadget_templates(size_t templates_per_pair) {
+    gadget_templates = templates_per_pair;
+}
+
 void HadamardTester::create_tester(const pcp::BinaryCSP &powering_pcp) { 
+    size_t templates = gadget_templates;
     *this = std::move(HadamardTester(powering_pcp));
+    gadget_templates = templates;
 }
 
 pcp::BinaryCSP HadamardTester::buildBinaryCSP() {
@@ -230,18 +297,42 @@ pcp::BinaryCSP HadamardTester::buildBinaryCSP() {
     );
 }
 
+pcp::BinaryCSP HadamardTester::buildBinaryCSP(util::philox &rng) {
+    return buildBinaryCSP(
+        constants::CONSTRAINT_COMBINATION_REPETITION,
+        constants::CONSISTENCY_TEST_REPETITION,
+        constants::LINEARITY_TEST_REPETITION,
+        rng
+    );
+}
+
 pcp::BinaryCSP HadamardTester::buildBinaryCSP(
     int constraint_combination_repetition,
     int consistency_test_repetition,
     int linearity_test_repetition
 ) {
+    util::philox rng(constants::RANDOM_SEED(), 0, 0);
+    return buildBinaryCSP(
+        constraint_combination_repetition,
+        consistency_test_repetition,
+        linearity_test_repetition,
+        rng
+    );
+}
+
+pcp::BinaryCSP HadamardTester::buildBinaryCSP(
+    int constraint_combination_repetition,
+    int consistency_test_repetition,
+    int linearity_test_repetition,
+    util::philox &rng
+) {
 
     size_t original_size = three_csp.size();
 
-    std::unordered_map<std::vector<bool>, size_t> used_positions;
-    std::vector<std::vector<bool>> used_positions_list;
+    std::unordered_map<Position, size_t, PositionHash> used_positions;
+    std::vector<Position> used_positions_list;
 
-    auto add_position = [&](const std::vector<bool>& position) {
+    auto add_position = [&](const Position& position) {
         if (used_positions.find(position) == used_positions.end()) {
             used_positions[position] = three_csp.size();
             three_csp.add_variable(hadamard.query(position));
@@ -249,50 +340,44 @@ pcp::BinaryCSP HadamardTester::buildBinaryCSP(
         }
     };
 
-    add_position(std::vector<bool>(original_size, 0));
+    const Position zero_position(original_size);
+    add_position(zero_position);
 
-    three_csp.add_variable(hadamard.query(std::vector<bool>(original_size, 0)));
+    three_csp.add_variable(hadamard.query(zero_position));
     std::uniform_int_distribution<pcp::Variable> bernoulli(0, 1);
 
     // add constraints from original constraint matrix
 
     for (size_t _ = 0; _ < constraint_combination_repetition; ++_) {
-        // random sample
-        std::vector<bool> sample(constraint_matrix.size());
-        for (size_t i = 0; i < constraint_matrix.size(); ++i) {
-            sample[i] = bernoulli(constants::RANDOM_SEED);
-        }
-
-        std::vector<bool> position(original_size);
-        for (size_t j = 0; j < constraint_matrix.size(); ++j) {
-            if (sample[j]) {
-                // include this constraint in the linear combination
-                for (size_t k = 0; k < constraint_matrix[j].size(); ++k) {
-                    position[k] = position[k] ^ constraint_matrix[j][k];
-                }
+        // random sample of rows, XORed into the position one nonzero at a time
+        Position position(original_size);
+        for (size_t j = 0; j < constraint_matrix.get_row_count(); ++j) {
+            if (bernoulli(rng)) {
+                constraint_matrix.add_to(j, position);
             }
         }
         add_position(position);
     }
 
-    size_t zero_pos = used_positions[std::vector<bool>(original_size, 0)];
-    for (const auto &[pos, idx] : used_positions) {
-        three_csp.add_binary_constraint(zero_pos, idx, constraint::BinaryConstraint::EQUAL);
+    size_t zero_pos = used_positions[zero_position];
+    // insertion order keeps the output independent of the hash function
+    for (const Position &pos : used_positions_list) {
+        three_csp.add_binary_constraint(zero_pos, used_positions[pos], constraint::BinaryConstraint::EQUAL);
     }
 
     std::uniform_int_distribution<size_t> dist(0, original_size - 1);
     // add linearity test to verify hadamard code encodes original variables correctly
     for (size_t _ = 0; _ < consistency_test_repetition; ++_) {
-        size_t idx = dist(constants::RANDOM_SEED);
+        size_t idx = dist(rng);
         if (binary_index_shift.find(idx) != binary_index_shift.end()) {
             idx = binary_index_shift[idx];
         }
 
         std::uniform_int_distribution<size_t> position_dist(0, used_positions_list.size() - 1);
-        std::vector<bool> position1 = used_positions_list[position_dist(constants::RANDOM_SEED)];
+        Position position1 = used_positions_list[position_dist(rng)];
 
-        std::vector<bool> position2 = position1;
-        position2[idx] = !position2[idx];
+        Position position2 = position1;
+        position2.flip(idx);
 
         add_position(position1);
         add_position(position2);
@@ -311,15 +396,13 @@ pcp::BinaryCSP HadamardTester::buildBinaryCSP(
         // only add positions that are already used for better coverage
         std::uniform_int_distribution<size_t> position_dist(0, used_positions_list.size() - 1);
 
-        std::vector<bool> position1 = used_positions_list[position_dist(constants::RANDOM_SEED)];
+        Position position1 = used_positions_list[position_dist(rng)];
 
-        std::vector<bool> position2 = used_positions_list[position_dist(constants::RANDOM_SEED)];
+        Position position2 = used_positions_list[position_dist(rng)];
 
         // position3 is the xor sum of position1 and position2
-        std::vector<bool> position3(original_size, 0);
-        for (size_t j = 0; j < original_size; ++j) {
-            position3[j] = position1[j] ^ position2[j];
-        }
+        Position position3 = position1;
+        position3 ^= position2;
 
         // ensure all three positions are added to three_csp
         add_position(position1);
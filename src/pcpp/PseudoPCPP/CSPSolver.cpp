@@ -1,3 +1,4 @@
+#include <cstdint>
 #include <functional>
 #include <vector>
 #include <map>
@@ -68,14 +69,12 @@ std::optional<pcp::BinaryCSP> merge_equal_constraints_helper(const pcp::BinaryCS
         }
     }
     
-    // Create new BinaryCSP with merged variables
+    // Create new BinaryCSP with merged variables, numbered in order of their first member
+    std::vector<std::uint32_t> labels = dsu.compress_all();
     std::vector<pcp::BinaryDomain> new_variables;
-    std::map<size_t, size_t> representative_to_index;
-    
+    new_variables.reserve(dsu.get_set_count());
     for (size_t i = 0; i < n; ++i) {
-        size_t rep = dsu.find(i);
-        if (representative_to_index.find(rep) == representative_to_index.end()) {
-            representative_to_index[rep] = new_variables.size();
+        if (labels[i] == new_variables.size()) {
             new_variables.push_back(input.get_variable(i));
         }
     }
@@ -85,10 +84,10 @@ std::optional<pcp::BinaryCSP> merge_equal_constraints_helper(const pcp::BinaryCS
     // Add constraints to merged BinaryCSP
     for (const auto &[var1, var2, constraint] : input.get_constraints_list()) {
         if (constraint != constraint::BinaryConstraint::EQUAL) {
-            size_t rep1 = dsu.find(var1);
-            size_t rep2 = dsu.find(var2);
-            if (rep1 != rep2) {
-                merged_pcp.add_constraint(representative_to_index[rep1], representative_to_index[rep2], constraint);
+            std::uint32_t label1 = labels[var1];
+            std::uint32_t label2 = labels[var2];
+            if (label1 != label2) {
+                merged_pcp.add_constraint(label1, label2, constraint);
             } else {
                 if (constraint == constraint::BinaryConstraint::NOTEQUAL) {
                     // Contradiction found, return nullopt to indicate unsatisfiability
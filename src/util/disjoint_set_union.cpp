@@ -1,32 +1,77 @@
 #include "util/disjoint_set_union.hpp"
 
-#include <numeric>
+#include <stdexcept>
 
 namespace util {
 
-disjoint_set_union::disjoint_set_union(size_t size) : size(size), representative(size) {
-    std::iota(representative.begin(), representative.end(), 0);
+disjoint_set_union::disjoint_set_union(size_t size) : size(0), set_count(0) {
+    grow(size);
 }
 
+size_t disjoint_set_union::get_size() const { return size; }
+
+size_t disjoint_set_union::get_set_count() const { return set_count; }
+
 size_t disjoint_set_union::find(size_t x) {
-    if (representative[x] != x) {
-        representative[x] = find(representative[x]);
+    size_t root = x;
+    while (!(node[root] & ROOT)) {
+        root = node[root];
     }
-    return representative[x];
+    // second pass points the whole path straight at the root
+    while (x != root) {
+        size_t next = node[x];
+        node[x] = static_cast<std::uint32_t>(root);
+        x = next;
+    }
+    return root;
 }
 
 bool disjoint_set_union::merge(size_t x, size_t y) {
     size_t rep_x = find(x);
     size_t rep_y = find(y);
-    if (rep_x != rep_y) {
-        representative[rep_y] = rep_x;
-        return true;
-    }
-    return false;
+    if (rep_x == rep_y) return false;
+    // ranks are stored below the ROOT tag, so comparing the words compares the ranks
+    if (node[rep_x] < node[rep_y]) std::swap(rep_x, rep_y);
+    if (node[rep_x] == node[rep_y]) ++node[rep_x];
+    node[rep_y] = static_cast<std::uint32_t>(rep_x);
+    --set_count;
+    return true;
 }
 
 bool disjoint_set_union::same_set(size_t x, size_t y) {
     return find(x) == find(y);
 }
 
-}
\ No newline at end of file
+void disjoint_set_union::grow(size_t new_size) {
+    if (new_size <= size) return;
+    if (new_size > MAX_SIZE) {
+        throw std::length_error("disjoint_set_union: size exceeds MAX_SIZE");
+    }
+    node.resize(new_size, ROOT);
+    set_count += new_size - size;
+    size = new_size;
+}
+
+size_t disjoint_set_union::merge_all(const std::vector<std::pair<size_t, size_t>> &pairs) {
+    size_t merged = 0;
+    for (const auto &[x, y] : pairs) {
+        merged += merge(x, y);
+    }
+    return merged;
+}
+
+std::vector<std::uint32_t> disjoint_set_union::compress_all() {
+    const std::uint32_t UNLABELED = ROOT;
+    std::vector<std::uint32_t> labels(size, UNLABELED);
+    std::uint32_t next_label = 0;
+    for (size_t x = 0; x < size; ++x) {
+        size_t root = find(x);
+        if (labels[root] == UNLABELED) {
+            labels[root] = next_label++;
+        }
+        labels[x] = labels[root];
+    }
+    return labels;
+}
+
+}
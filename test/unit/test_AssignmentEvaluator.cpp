@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "analyzer/AssignmentEvaluator.hpp"
+#include "constants.hpp"
+#include "constraint/BinaryConstraint.hpp"
+#include "pcp/BinaryCSP.hpp"
+#include "pcp/BinaryDomain.hpp"
+
+namespace {
+
+// random variables of every domain type and random constraints of every kind
+pcp::BinaryCSP random_csp(size_t variables, size_t edges, std::mt19937 &rng) {
+    std::uniform_int_distribution<int> bit(0, 1), domain(0, 4), kind(0, 5);
+    std::uniform_int_distribution<size_t> var(0, variables - 1);
+    std::vector<pcp::BinaryDomain> vars;
+    for (size_t i = 0; i < variables; ++i) {
+        vars.emplace_back(bit(rng), bit(rng), bit(rng), static_cast<three_csp::Constraint>(domain(rng)));
+    }
+    std::vector<std::tuple<pcp::Variable, pcp::Variable, constraint::BinaryConstraint>> list;
+    for (size_t e = 0; e < edges; ++e) {
+        list.emplace_back(var(rng), var(rng), static_cast<constraint::BinaryConstraint>(kind(rng)));
+    }
+    return pcp::BinaryCSP(std::move(vars), std::move(list));
+}
+
+// the fraction of satisfied constraints the slow way
+double reference(const pcp::BinaryCSP &pcp, const std::vector<pcp::BinaryDomain> &assignment) {
+    const auto &list = pcp.get_constraints_list();
+    if (list.empty()) return 1.0;
+    size_t satisfied = 0;
+    for (const auto &[u, v, c] : list) {
+        satisfied += constraint::evaluateBinaryConstraint(c, assignment[u], assignment[v]);
+    }
+    return static_cast<double>(satisfied) / static_cast<double>(list.size());
+}
+
+}
+
+std::vector<std::function<void()>> test_cases = {
+    []() -> void {
+        // Test case 1: matches the scalar evaluation, including edge counts that leave a tail after 8-wide steps
+        std::mt19937 rng(1);
+        for (size_t edges : {1, 7, 8, 9, 100, 1003}) {
+            pcp::BinaryCSP pcp = random_csp(50, edges, rng);
+            assert(analyzer::evaluate_assignment(pcp) == reference(pcp, pcp.get_variables()));
+        }
+    },
+    []() -> void {
+        // Test case 2: explicit assignments, no constraints, and a wrong assignment size
+        pcp::BinaryCSP pcp(std::vector<pcp::BinaryDomain>{0, 1, 1});
+        pcp.add_constraint(0, 1, constraint::BinaryConstraint::EQUAL);
+        pcp.add_constraint(1, 2, constraint::BinaryConstraint::NOTEQUAL);
+        assert(analyzer::evaluate_assignment(pcp) == 0.0);
+        assert(analyzer::evaluate_assignment(pcp, {1, 1, 0}) == 1.0);
+        assert(analyzer::evaluate_assignment(pcp, {1, 1, 1}) == 0.5);
+        assert(analyzer::evaluate_assignment(pcp::BinaryCSP(4)) == 1.0);
+        bool threw = false;
+        try {
+            analyzer::evaluate_assignment(pcp, {1, 1});
+        } catch (const std::invalid_argument &) {
+            threw = true;
+        }
+        assert(threw);
+    },
+    []() -> void {
+        // Test case 3: a CSP above the threaded reduction threshold
+        std::mt19937 rng(3);
+        pcp::BinaryCSP pcp = random_csp(1 << 16, constants::EVALUATE_PARALLEL_THRESHOLD + 12345, rng);
+        analyzer::EdgeArrays edges(pcp);
+        std::vector<std::uint8_t> values(pcp.get_size());
+        for (size_t i = 0; i < pcp.get_size(); ++i) {
+            values[i] = pcp.get_variable(static_cast<pcp::Variable>(i)).get_packed();
+        }
+        size_t threaded = analyzer::count_satisfied(edges, values.data());
+        assert(threaded == analyzer::count_satisfied(edges, values.data(), 0, edges.size()));
+        assert(static_cast<double>(threaded) / edges.size() == reference(pcp, pcp.get_variables()));
+    },
+    []() -> void {
+        // Test case 4: values without padding, full blocks of edges on the last variables and unaligned ranges
+        std::mt19937 rng(4);
+        for (size_t variables : {1, 2, 3, 4, 5, 40}) {
+            pcp::BinaryCSP pcp = random_csp(variables, 64, rng);
+            for (pcp::Variable k = 0; k < 16; ++k) {
+                pcp.add_constraint(variables - 1, variables - 1 - k % variables, constraint::BinaryConstraint::NOTEQUAL);
+            }
+            analyzer::EdgeArrays edges(pcp);
+            std::vector<std::uint8_t> values(variables);
+            for (size_t i = 0; i < variables; ++i) {
+                values[i] = pcp.get_variable(static_cast<pcp::Variable>(i)).get_packed();
+            }
+            const auto &list = pcp.get_constraints_list();
+            for (size_t first : {0, 3, 8}) {
+                for (size_t last : {size_t(13), size_t(64), list.size()}) {
+                    size_t expected = 0;
+                    for (size_t e = first; e < last; ++e) {
+                        const auto &[u, v, c] = list[e];
+                        expected += constraint::evaluateBinaryConstraint(c, pcp.get_variable(u), pcp.get_variable(v));
+                    }
+                    assert(analyzer::count_satisfied(edges, values.data(), first, last) == expected);
+                }
+            }
+        }
+    },
+};
+
+int main() {
+    for (size_t i = 0; i < test_cases.size(); ++i) {
+        test_cases[i]();
+        std::cout << "Passed test case " << (i + 1) << std::endl;
+    }
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "constraint/BinaryConstraint.hpp"
+#include "pcp/BinaryDomain.hpp"
+
+namespace {
+
+const std::vector<three_csp::Constraint> domain_types = {
+    three_csp::Constraint::ANY,
+    three_csp::Constraint::PRODUCT,
+    three_csp::Constraint::SUM,
+    three_csp::Constraint::ENCODED_BINARY,
+    three_csp::Constraint::ONE_HOT_COLOR,
+};
+
+// reference semantics of every BinaryConstraint, written against the public accessors
+bool reference_evaluate(constraint::BinaryConstraint c, pcp::BinaryDomain x, pcp::BinaryDomain y) {
+    bool same = x.get_domain_type() == y.get_domain_type();
+    for (size_t i = 0; i < 3; ++i) {
+        same = same && x[i] == y[i];
+    }
+    switch (c) {
+        case constraint::BinaryConstraint::ANY: return true;
+        case constraint::BinaryConstraint::EQUAL: return same;
+        case constraint::BinaryConstraint::NOTEQUAL: return !same;
+        case constraint::BinaryConstraint::FIRST_BIT_EQUAL: return x[0] == y[0];
+        case constraint::BinaryConstraint::SECOND_BIT_EQUAL: return x[1] == y[1];
+        case constraint::BinaryConstraint::THIRD_BIT_EQUAL: return x[2] == y[2];
+    }
+    return false;
+}
+
+}
+
+std::vector<std::function<void()>> test_cases = {
+    // Test 1: every value and domain type round-trips through the packed byte
+    []() -> void {
+        for (auto type : domain_types) {
+            for (int value = 0; value < 8; ++value) {
+                pcp::BinaryDomain d(value & 1, (value >> 1) & 1, (value >> 2) & 1, type);
+                assert(d.get_value() == value);
+                assert(d.get_domain_type() == type);
+                assert(pcp::BinaryDomain::from_packed(d.get_packed()) == d);
+                assert(pcp::BinaryDomain(value, type) == d);
+            }
+        }
+        // plain integer construction keeps only the three value bits
+        assert(pcp::BinaryDomain(9) == pcp::BinaryDomain(1));
+        assert(pcp::BinaryDomain().get_domain_type() == three_csp::Constraint::ANY);
+    },
+    // Test 2: changing the domain type keeps the value bits
+    []() -> void {
+        pcp::BinaryDomain d(1, 0, 1, three_csp::Constraint::SUM);
+        d.set_domain_type(three_csp::Constraint::PRODUCT);
+        assert(d.get_value() == 5);
+        assert(d.get_domain_type() == three_csp::Constraint::PRODUCT);
+        assert(d != pcp::BinaryDomain(5, three_csp::Constraint::SUM));
+    },
+    // Test 3: packed evaluation agrees with the reference on all value, type and constraint combinations
+    []() -> void {
+        for (auto tx : domain_types) for (auto ty : domain_types) {
+            for (int vx = 0; vx < 8; ++vx) for (int vy = 0; vy < 8; ++vy) {
+                pcp::BinaryDomain x(vx, tx), y(vy, ty);
+                for (int c = 0; c <= static_cast<int>(constraint::BinaryConstraint::THIRD_BIT_EQUAL); ++c) {
+                    auto con = static_cast<constraint::BinaryConstraint>(c);
+                    bool expected = reference_evaluate(con, x, y);
+                    assert(constraint::evaluateBinaryConstraint(con, x, y) == expected);
+                    assert(constraint::evaluatePackedBinaryConstraint(con, x.get_packed(), y.get_packed()) == expected);
+                }
+            }
+        }
+    }
+};
+
+int main() {
+    for (size_t i = 0; i < test_cases.size(); ++i) {
+        test_cases[i]();
+        std::cout << "Passed test case " << (i + 1) << std::endl;
+    }
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
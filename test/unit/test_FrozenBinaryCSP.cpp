@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "pcp/BinaryCSP.hpp"
+#include "pcp/BinaryDomain.hpp"
+#include "pcp/FrozenBinaryCSP.hpp"
+
+namespace {
+
+// random multigraph with self-loops and mixed constraint types
+pcp::BinaryCSP random_pcp(size_t size, size_t edges, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> var_dist(0, size - 1);
+    std::uniform_int_distribution<int> value_dist(0, 7);
+    std::uniform_int_distribution<int> constraint_dist(0, 5);
+    pcp::BinaryCSP pcp(size);
+    for (size_t i = 0; i < size; ++i) {
+        pcp.set_variable(i, pcp::BinaryDomain(value_dist(rng)));
+    }
+    for (size_t i = 0; i < edges; ++i) {
+        pcp.add_constraint(var_dist(rng), var_dist(rng), static_cast<constraint::BinaryConstraint>(constraint_dist(rng)));
+    }
+    return pcp;
+}
+
+bool same_pcp(const pcp::BinaryCSP &a, const pcp::BinaryCSP &b) {
+    if (a.get_size() != b.get_size() || a.get_constraints_list() != b.get_constraints_list()) {
+        return false;
+    }
+    for (pcp::Variable i = 0; i < a.get_size(); ++i) {
+        if (a.get_variable(i) != b.get_variable(i)) return false;
+        if (a.get_constraints(i) != b.get_constraints(i)) return false;
+        if (a.get_constraints_indices(i) != b.get_constraints_indices(i)) return false;
+    }
+    return true;
+}
+
+// hash map based sub-CSP construction, edge by edge
+pcp::BinaryCSP reference_sub_pcp(const pcp::BinaryCSP &pcp, const std::vector<pcp::Variable> &ball) {
+    std::unordered_map<pcp::Variable, pcp::Variable> index_map;
+    pcp::BinaryCSP sub(ball.size());
+    for (size_t i = 0; i < ball.size(); ++i) {
+        sub.set_variable(i, pcp.get_variable(ball[i]));
+        index_map[ball[i]] = i;
+    }
+    for (size_t i = 0; i < ball.size(); ++i) {
+        for (const auto &[v, constraint] : pcp.get_constraints(ball[i])) {
+            if (constraint != constraint::BinaryConstraint::ANY && index_map.count(v)) {
+                sub.add_constraint(i, index_map[v], constraint);
+            }
+        }
+    }
+    return sub;
+}
+
+}
+
+std::vector<std::function<void()>> test_cases = {
+    // Test 1: adjacency rows match BinaryCSP::get_constraints entry by entry
+    []() -> void {
+        pcp::BinaryCSP pcp = random_pcp(50, 200, 1);
+        pcp::FrozenBinaryCSP frozen(pcp);
+        assert(frozen.get_size() == pcp.get_size());
+        assert(frozen.get_constraints_list() == pcp.get_constraints_list());
+        for (pcp::Variable i = 0; i < pcp.get_size(); ++i) {
+            const auto &expected = pcp.get_constraints(i);
+            pcp::ConstraintView row = frozen.get_constraints(i);
+            assert(row.size() == expected.size());
+            size_t j = 0;
+            for (const auto &[neighbor, constraint] : row) {
+                assert(neighbor == expected[j].first);
+                assert(constraint == expected[j].second);
+                assert(row.neighbors()[j] == expected[j].first);
+                ++j;
+            }
+        }
+    },
+    // Test 2: BFS order and sub-CSPs are identical to the mutable representation
+    []() -> void {
+        pcp::BinaryCSP pcp = random_pcp(80, 160, 2);
+        pcp::FrozenBinaryCSP frozen(pcp);
+        for (pcp::Variable i = 0; i < pcp.get_size(); ++i) {
+            for (int radius = 0; radius <= 3; ++radius) {
+                std::vector<pcp::Variable> expected = pcp.get_neighbors(i, radius);
+                assert(frozen.get_neighbors(i, radius) == expected);
+                assert(same_pcp(frozen.build_sub_pcp(expected), pcp.build_sub_pcp(expected)));
+            }
+        }
+    },
+    // Test 3: isolated variables, empty CSPs and moving out of a BinaryCSP
+    []() -> void {
+        pcp::FrozenBinaryCSP empty;
+        assert(empty.get_size() == 0);
+        assert(empty.get_constraints_list().empty());
+
+        pcp::BinaryCSP pcp(std::vector<pcp::BinaryDomain>{1, 2, 3});
+        pcp.add_constraint(0, 2, constraint::BinaryConstraint::EQUAL);
+        pcp::BinaryCSP copy = pcp;
+        pcp::FrozenBinaryCSP frozen(std::move(pcp));
+        assert(frozen.get_constraints(1).empty());
+        assert(frozen.get_neighbors(1, 5) == std::vector<pcp::Variable>{1});
+        assert(same_pcp(frozen.thaw(), copy));
+
+        frozen.set_variable(1, pcp::BinaryDomain(5));
+        assert(frozen.get_variable(1) == pcp::BinaryDomain(5));
+    },
+    // Test 4: out of range constraints are rejected
+    []() -> void {
+        bool threw = false;
+        try {
+            pcp::FrozenBinaryCSP frozen(
+                std::vector<pcp::BinaryDomain>(2),
+                {{0, 2, constraint::BinaryConstraint::EQUAL}}
+            );
+        } catch (const std::out_of_range &e) {
+            threw = true;
+        }
+        assert(threw);
+    },
+    // Test 5: dense remap sub-CSPs match the hash map construction, also for arbitrary variable subsets
+    []() -> void {
+        pcp::BinaryCSP pcp = random_pcp(120, 300, 5);
+        pcp::FrozenBinaryCSP frozen(pcp);
+        util::bfs_workspace workspace;
+        std::mt19937 rng(5);
+        std::vector<pcp::Variable> all(pcp.get_size());
+        for (pcp::Variable i = 0; i < pcp.get_size(); ++i) all[i] = i;
+        for (int round = 0; round < 200; ++round) {
+            std::vector<pcp::Variable> ball;
+            if (round % 2 == 0) {
+                ball = pcp.get_neighbors(rng() % pcp.get_size(), round % 5, workspace);
+            } else {
+                std::shuffle(all.begin(), all.end(), rng);
+                ball.assign(all.begin(), all.begin() + rng() % pcp.get_size());
+            }
+            pcp::BinaryCSP expected = reference_sub_pcp(pcp, ball);
+            assert(same_pcp(pcp.build_sub_pcp(ball, workspace), expected));
+            assert(same_pcp(frozen.build_sub_pcp(ball, workspace), expected));
+            assert(same_pcp(frozen.build_sub_pcp(ball), expected));
+        }
+    }
+};
+
+int main() {
+    for (size_t i = 0; i < test_cases.size(); ++i) {
+        test_cases[i]();
+        std::cout << "Passed test case " << (i + 1) << std::endl;
+    }
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -3,7 +3,10 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <random>
+#include <stdexcept>
 
+#include "pcpp/HadamardPCPP/ConstraintMatrix.hpp"
 #include "pcpp/HadamardPCPP/Hadamard.hpp"
 
 std::vector<std::function<void()>> test_cases = {
@@ -35,6 +38,94 @@ std::vector<std::function<void()>> test_cases = {
         pcpp::Hadamard h(value);
         std::vector<bool> expected_code = {false, false, true, true, true, true, false, false};
         assert(h.getCode() == expected_code);
+    },
+    // Test 5: packed queries agree with the bitwise inner product across word boundaries
+    []() -> void {
+        std::mt19937 rng(5);
+        for (size_t size : {1, 63, 64, 65, 130, 1000}) {
+            std::vector<bool> value(size);
+            for (size_t i = 0; i < size; ++i) value[i] = rng() & 1;
+            pcpp::Hadamard h(value);
+            for (int repeat = 0; repeat < 20; ++repeat) {
+                std::vector<bool> idx(size);
+                bool expected = false;
+                for (size_t i = 0; i < size; ++i) {
+                    idx[i] = rng() & 1;
+                    expected ^= idx[i] && value[i];
+                }
+                assert(h.query(idx) == expected);
+                assert(h.query(pcpp::Position(idx)) == expected);
+            }
+        }
+    },
+    // Test 6: Position bit access, XOR, equality and hashing
+    []() -> void {
+        pcpp::Position a(130), b(130);
+        a.set(0, true);
+        a.set(64, true);
+        a.set(129, true);
+        assert(a.get(0) && a.get(64) && a.get(129) && !a.get(1) && a.size() == 130);
+        b.flip(64);
+        b.flip(100);
+        a ^= b;
+        assert(a.get(0) && !a.get(64) && a.get(100) && a.get(129));
+        pcpp::Position c(std::vector<bool>(130, false));
+        c.set(0, true);
+        c.set(100, true);
+        c.set(129, true);
+        assert(a == c && a.hash() == c.hash());
+        c.set(129, false);
+        assert(a != c);
+        assert(pcpp::Position(64) != pcpp::Position(65));
+        assert(pcpp::Position(0) == pcpp::Position(0));
+    },
+    // Test 7: sparse constraint rows XOR into positions like their dense form
+    []() -> void {
+        pcpp::ConstraintMatrix matrix(130);
+        matrix.add_row(std::vector<size_t>{129, 3, 3, 64});
+        pcpp::Position dense(130);
+        dense.set(1, true);
+        dense.set(127, true);
+        matrix.add_row(dense);
+        assert(matrix.get_row_count() == 2 && matrix.get_width() == 130);
+        assert((std::vector<size_t>(matrix.get_row(0).begin(), matrix.get_row(0).end()) == std::vector<size_t>{3, 64, 129}));
+        assert(matrix.dense_row(1) == dense);
+
+        pcpp::Position position(130);
+        position.set(64, true);
+        matrix.add_to(0, position);
+        matrix.add_to(1, position);
+        assert(position.get(1) && position.get(3) && !position.get(64) && position.get(127) && position.get(129));
+        position ^= matrix.dense_row(0);
+        position ^= dense;
+        assert(position.get(64) && !position.get(1) && !position.get(3) && !position.get(129));
+
+        bool thrown = false;
+        try {
+            matrix.add_row(std::vector<size_t>{130});
+        } catch (const std::out_of_range &) {
+            thrown = true;
+        }
+        assert(thrown && matrix.get_row_count() == 2);
+    },
+    // Test 8: Gray code and packed codewords agree with querying every position
+    []() -> void {
+        std::mt19937 rng(8);
+        for (size_t size = 0; size <= 12; ++size) {
+            std::vector<bool> value(size);
+            for (size_t i = 0; i < size; ++i) value[i] = rng() & 1;
+            pcpp::Hadamard h(value);
+            std::vector<bool> code = h.getCode();
+            pcpp::Position packed = h.getPackedCode();
+            assert(code.size() == (size_t(1) << size) && packed.size() == code.size());
+            for (size_t x = 0; x < code.size(); ++x) {
+                std::vector<bool> idx(size);
+                for (size_t j = 0; j < size; ++j) idx[j] = (x >> j) & 1;
+                assert(code[x] == h.query(idx));
+                assert(packed.get(x) == code[x]);
+            }
+            assert(packed == pcpp::Position(code));
+        }
     }
 };
 
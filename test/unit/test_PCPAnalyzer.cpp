@@ -84,6 +84,73 @@ std::vector<std::function<void()>> test_cases = {
         assert(abs(soundness - 0.6) < 1e-2); // 2 out of 5 constraints violated
         assert(abs(gap - (completeness - soundness)) < 1e-5); // Correct gap calculation
     },
+    []() -> void {
+        // Test case 5: batched queries and reproducible estimates over many samples and chunks
+        pcp::BinaryCSP pcp5(std::vector<pcp::BinaryDomain>{0, 1, 1, 0});
+        pcp5.add_constraint(0, 1, constraint::BinaryConstraint::EQUAL);
+        pcp5.add_constraint(1, 2, constraint::BinaryConstraint::EQUAL);
+        pcp5.add_constraint(2, 3, constraint::BinaryConstraint::NOTEQUAL);
+        util::philox rng(5, 0, 0);
+        size_t satisfied = analyzer::query_batch(pcp5, 100000, rng);
+        assert(abs(satisfied / 100000.0 - 2.0 / 3.0) < 1e-2);
+        assert(analyzer::query_batch(pcp::BinaryCSP(3), 1000, rng) == 1000);
+
+        std::vector<std::pair<pcp::BinaryCSP, analyzer::Satisfiability>> samples;
+        for (int i = 0; i < 8; ++i) {
+            samples.emplace_back(pcp5, i % 2 == 0);
+        }
+        analyzer::PCPAnalyzer first(samples, 10000);
+        analyzer::PCPAnalyzer second(samples, 10000);
+        assert(first.getSoundness() == second.getSoundness());
+        assert(first.getCompleteness() == second.getCompleteness());
+        assert(abs(first.getSoundness() - 2.0 / 3.0) < 1e-2);
+    },
+    []() -> void {
+        // Test case 6: adaptive stopping shrinks the interval to the requested width with fewer queries
+        pcp::BinaryCSP sat(std::vector<pcp::BinaryDomain>{0, 0, 1});
+        sat.add_constraint(0, 1, constraint::BinaryConstraint::EQUAL);
+        sat.add_constraint(1, 2, constraint::BinaryConstraint::NOTEQUAL);
+        pcp::BinaryCSP unsat(std::vector<pcp::BinaryDomain>{0, 1, 1, 0});
+        unsat.add_constraint(0, 1, constraint::BinaryConstraint::EQUAL);
+        unsat.add_constraint(1, 2, constraint::BinaryConstraint::EQUAL);
+        unsat.add_constraint(2, 3, constraint::BinaryConstraint::NOTEQUAL);
+        std::vector<std::pair<pcp::BinaryCSP, analyzer::Satisfiability>> samples = {
+            {sat, true},
+            {unsat, false},
+        };
+        const int max_trial = 1000000;
+        for (analyzer::IntervalMethod method : {analyzer::IntervalMethod::WILSON, analyzer::IntervalMethod::HOEFFDING}) {
+            analyzer::PCPAnalyzer adaptive(samples, max_trial, 0.02, method);
+            assert(adaptive.getQueriesUsed() < 2 * static_cast<size_t>(max_trial) / 10);
+            assert(adaptive.getCompleteness() == 1.0);
+            for (const analyzer::AcceptanceEstimate &estimate : adaptive.getEstimates()) {
+                assert(estimate.upper - estimate.lower <= 0.02);
+                assert(estimate.lower <= estimate.acceptance && estimate.acceptance <= estimate.upper);
+            }
+            auto [lower, upper] = adaptive.getSoundnessInterval();
+            assert(lower <= 2.0 / 3.0 && 2.0 / 3.0 <= upper);
+            assert(adaptive.getCompletenessInterval().second == 1.0);
+
+            analyzer::PCPAnalyzer again(samples, max_trial, 0.02, method);
+            assert(again.getSoundness() == adaptive.getSoundness());
+            assert(again.getQueriesUsed() == adaptive.getQueriesUsed());
+        }
+
+        // a width that can never be reached falls back to every trial
+        analyzer::PCPAnalyzer exhaustive(samples, 10000, 0.0);
+        assert(exhaustive.getQueriesUsed() == 20000);
+        analyzer::PCPAnalyzer fixed(samples, 10000);
+        assert(exhaustive.getSoundness() == fixed.getSoundness());
+
+        // the confidence level is shared by the samples, so more samples widen every per-sample interval
+        std::vector<std::pair<pcp::BinaryCSP, analyzer::Satisfiability>> many(8, {unsat, false});
+        std::vector<std::pair<pcp::BinaryCSP, analyzer::Satisfiability>> alone(1, {unsat, false});
+        analyzer::PCPAnalyzer one(alone, 10000);
+        analyzer::PCPAnalyzer eight(many, 10000);
+        const analyzer::AcceptanceEstimate &single = one.getEstimates()[0], &shared = eight.getEstimates()[0];
+        assert(single.acceptance == shared.acceptance);
+        assert(shared.upper - shared.lower > single.upper - single.lower);
+    },
 };
 
 int main() {
@@ -1,6 +1,10 @@
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "analyzer/SoundnessApproximater.hpp"
@@ -50,6 +54,158 @@ std::vector<std::function<void()>> test_cases = {
         p3.add_constraint(2, 0, BinaryConstraint::NOTEQUAL);
         double res3 = analyzer::approximate_soundness(p3);
         assert(std::fabs(res3 - (2.0/3.0)) < 1e-9);
+    },
+    []() {
+        using namespace pcp;
+        using namespace three_csp;
+        using namespace constraint;
+        // Same triangle with several chains
+        std::vector<BinaryDomain> vars4(3, BinaryDomain(false, false, false, Constraint::ANY));
+        BinaryCSP p4(std::move(vars4));
+        p4.add_constraint(0, 1, BinaryConstraint::EQUAL);
+        p4.add_constraint(1, 2, BinaryConstraint::EQUAL);
+        p4.add_constraint(2, 0, BinaryConstraint::NOTEQUAL);
+        double res4 = analyzer::approximate_soundness_multi_chain(p4, 4);
+        assert(std::fabs(res4 - (2.0/3.0)) < 1e-9);
+    },
+    []() {
+        using namespace pcp;
+        using namespace three_csp;
+        using namespace constraint;
+        // Random frustrated CSP: multi-chain runs are reproducible and never worse than their first chain alone
+        std::mt19937 rng(2024);
+        const Constraint domains[] = {Constraint::ANY, Constraint::SUM, Constraint::PRODUCT, Constraint::ONE_HOT_COLOR};
+        const BinaryConstraint types[] = {BinaryConstraint::EQUAL, BinaryConstraint::NOTEQUAL,
+            BinaryConstraint::FIRST_BIT_EQUAL, BinaryConstraint::SECOND_BIT_EQUAL, BinaryConstraint::THIRD_BIT_EQUAL};
+        std::vector<BinaryDomain> vars5;
+        for (int i = 0; i < 60; ++i) vars5.push_back(BinaryDomain(0, domains[rng() % 4]));
+        BinaryCSP p5(std::move(vars5));
+        for (int i = 0; i < 240; ++i) {
+            p5.add_constraint(rng() % 60, rng() % 60, types[rng() % 5]);
+        }
+
+        BinaryCSP single = p5;
+        double single_res = analyzer::approximate_soundness(single, 200, 5);
+        BinaryCSP first = p5, second = p5;
+        double first_res = analyzer::approximate_soundness_multi_chain(first, 4, 200, 5);
+        double second_res = analyzer::approximate_soundness_multi_chain(second, 4, 200, 5);
+        assert(first_res == second_res);
+        assert(first_res >= single_res);
+        for (Variable i = 0; i < static_cast<Variable>(first.get_size()); ++i) {
+            assert(first.get_variable(i) == second.get_variable(i));
+        }
+    },
+    []() {
+        using namespace pcp;
+        using namespace three_csp;
+        using namespace constraint;
+        // Replica exchange on the triangle: converges to 2/3 and reports a non-decreasing trace
+        std::vector<BinaryDomain> vars6(3, BinaryDomain(false, false, false, Constraint::ANY));
+        BinaryCSP p6(std::move(vars6));
+        p6.add_constraint(0, 1, BinaryConstraint::EQUAL);
+        p6.add_constraint(1, 2, BinaryConstraint::EQUAL);
+        p6.add_constraint(2, 0, BinaryConstraint::NOTEQUAL);
+        analyzer::TemperingResult res6 = analyzer::approximate_soundness_tempering(p6, 4, 50, 100);
+        assert(std::fabs(res6.soundness - (2.0/3.0)) < 1e-9);
+        assert(res6.trace.size() == 50);
+        assert(std::is_sorted(res6.trace.begin(), res6.trace.end()));
+        assert(res6.trace.back() == res6.soundness);
+        assert(res6.swap_acceptance.size() == 3);
+    },
+    []() {
+        using namespace pcp;
+        using namespace three_csp;
+        using namespace constraint;
+        // Replica exchange stops once everything is satisfied and is reproducible
+        std::vector<BinaryDomain> vars7(40, BinaryDomain(0, Constraint::SUM));
+        BinaryCSP p7(std::move(vars7));
+        for (Variable i = 0; i + 1 < 40; ++i) {
+            p7.add_constraint(i, i + 1, i % 2 ? BinaryConstraint::THIRD_BIT_EQUAL : BinaryConstraint::FIRST_BIT_EQUAL);
+        }
+        BinaryCSP first = p7, second = p7;
+        analyzer::TemperingResult res_first = analyzer::approximate_soundness_tempering(first, 6, 1000, 500, 3);
+        analyzer::TemperingResult res_second = analyzer::approximate_soundness_tempering(second, 6, 1000, 500, 3);
+        assert(res_first.soundness == 1.0);
+        assert(res_first.trace.size() < 1000);
+        assert(res_first.trace == res_second.trace);
+        assert(res_first.swap_acceptance == res_second.swap_acceptance);
+        for (Variable i = 0; i < static_cast<Variable>(first.get_size()); ++i) {
+            assert(first.get_variable(i) == second.get_variable(i));
+        }
+    },
+    []() {
+        using namespace pcp;
+        using namespace three_csp;
+        using namespace constraint;
+        // Walk search on the triangle finds 2/3 and on a satisfiable chain stops as soon as nothing is violated
+        std::vector<BinaryDomain> vars8(3, BinaryDomain(false, false, false, Constraint::ANY));
+        BinaryCSP p8(std::move(vars8));
+        p8.add_constraint(0, 1, BinaryConstraint::EQUAL);
+        p8.add_constraint(1, 2, BinaryConstraint::EQUAL);
+        p8.add_constraint(2, 0, BinaryConstraint::NOTEQUAL);
+        analyzer::SearchReport res8 = analyzer::approximate_soundness_walksat(p8, 1000);
+        assert(std::fabs(res8.soundness - (2.0/3.0)) < 1e-9);
+        assert(res8.flips == 1000);
+        assert(res8.seconds_to_best <= res8.seconds);
+
+        std::vector<BinaryDomain> vars9(200, BinaryDomain(0, Constraint::ONE_HOT_COLOR));
+        BinaryCSP p9(std::move(vars9));
+        for (Variable i = 0; i + 1 < 200; ++i) {
+            p9.add_constraint(i, i + 1, i % 3 ? BinaryConstraint::NOTEQUAL : BinaryConstraint::EQUAL);
+        }
+        analyzer::SearchReport res9 = analyzer::approximate_soundness_walksat(p9, 1000000);
+        assert(res9.soundness == 1.0);
+        assert(res9.flips < 1000000);
+        for (const auto &[u, v, c] : p9.get_constraints_list()) {
+            assert(evaluateBinaryConstraint(c, p9.get_variable(u), p9.get_variable(v)));
+        }
+
+        // variables of a domain type without possible values never change, so the steps are spent without a flip
+        std::vector<BinaryDomain> fixed = {BinaryDomain::from_packed(0x28), BinaryDomain::from_packed(0x29)};
+        BinaryCSP p_fixed(std::move(fixed));
+        p_fixed.add_constraint(0, 1, BinaryConstraint::EQUAL);
+        analyzer::SearchReport res_fixed = analyzer::approximate_soundness_walksat(p_fixed, 1000);
+        assert(res_fixed.soundness == 0.0);
+        assert(res_fixed.flips == 0);
+    },
+    []() {
+        using namespace pcp;
+        using namespace three_csp;
+        using namespace constraint;
+        // Engines are picked by name and report comparable numbers
+        std::vector<BinaryDomain> vars10(30, BinaryDomain(0, Constraint::SUM));
+        BinaryCSP p10(std::move(vars10));
+        for (Variable i = 0; i + 1 < 30; ++i) {
+            p10.add_constraint(i, i + 1, BinaryConstraint::SECOND_BIT_EQUAL);
+        }
+        for (const std::string engine : {"anneal", "multi_chain", "tempering", "walksat"}) {
+            BinaryCSP copy = p10;
+            analyzer::SearchReport report = analyzer::run_soundness_engine(engine, copy);
+            assert(report.soundness == 1.0);
+            assert(report.flips > 0);
+            assert(report.seconds_to_best <= report.seconds);
+        }
+        bool thrown = false;
+        try {
+            analyzer::run_soundness_engine("gradient_descent", p10);
+        } catch (const std::invalid_argument &) {
+            thrown = true;
+        }
+        assert(thrown);
+    },
+    []() {
+        using namespace pcp;
+        using namespace three_csp;
+        using namespace constraint;
+        // Random subsets of a satisfiable CSP much larger than the subset size are all satisfiable
+        std::vector<BinaryDomain> vars11(5000, BinaryDomain(0, Constraint::PRODUCT));
+        BinaryCSP p11(std::move(vars11));
+        for (Variable i = 0; i + 1 < 5000; ++i) {
+            p11.add_constraint(i, i + 1, i % 2 ? BinaryConstraint::NOTEQUAL : BinaryConstraint::THIRD_BIT_EQUAL);
+            p11.add_constraint(i, (i * 7 + 3) % 5000, BinaryConstraint::ANY);
+        }
+        double res11 = analyzer::approximate_soundness_via_random_subset(p11);
+        assert(res11 == 1.0);
     }
 };
 
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "util/concurrent_disjoint_set_union.hpp"
+#include "util/disjoint_set_union.hpp"
+#include "util/thread_pool.hpp"
+
+namespace {
+
+std::vector<std::pair<size_t, size_t>> random_pairs(size_t size, size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, size - 1);
+    std::vector<std::pair<size_t, size_t>> pairs(count);
+    for (auto &[x, y] : pairs) {
+        x = pick(rng);
+        y = pick(rng);
+    }
+    return pairs;
+}
+
+// every set of the concurrent DSU must match the reference and be rooted at its smallest element
+void check_against(util::concurrent_disjoint_set_union &dsu, util::disjoint_set_union &reference, size_t size) {
+    std::vector<size_t> smallest(size, size);
+    for (size_t i = 0; i < size; ++i) {
+        size_t root = reference.find(i);
+        if (smallest[root] == size) smallest[root] = i;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        assert(dsu.find(i) == smallest[reference.find(i)]);
+    }
+}
+
+}
+
+std::vector<std::function<void()>> test_cases = {
+    // Test 1: basic merges, set count and dense labels in order of the smallest element
+    []() -> void {
+        util::disjoint_set_union dsu(8);
+        assert(dsu.get_size() == 8 && dsu.get_set_count() == 8);
+        assert(dsu.merge(6, 2));
+        assert(dsu.merge(5, 6));
+        assert(!dsu.merge(2, 5));
+        assert(dsu.merge(7, 1));
+        assert(dsu.same_set(2, 5));
+        assert(!dsu.same_set(1, 2));
+        assert(dsu.get_set_count() == 5);
+        std::vector<std::uint32_t> labels = dsu.compress_all();
+        assert((labels == std::vector<std::uint32_t>{0, 1, 2, 3, 4, 2, 2, 1}));
+
+        std::vector<std::pair<size_t, size_t>> pairs = {{0, 3}, {3, 0}, {4, 4}, {1, 2}};
+        assert(dsu.merge_all(pairs) == 2);
+        assert(dsu.get_set_count() == 3);
+        labels = dsu.compress_all();
+        assert((labels == std::vector<std::uint32_t>{0, 1, 1, 0, 2, 1, 1, 1}));
+    },
+    // Test 2: long chains merged in the worst order stay shallow and need no recursion
+    []() -> void {
+        const size_t size = 2000000;
+        util::disjoint_set_union dsu(size);
+        for (size_t i = size - 1; i > 0; --i) {
+            dsu.merge(i, i - 1);
+        }
+        assert(dsu.get_set_count() == 1);
+        size_t root = dsu.find(0);
+        for (size_t i = 0; i < size; ++i) {
+            assert(dsu.find(i) == root);
+        }
+        std::vector<std::uint32_t> labels = dsu.compress_all();
+        for (std::uint32_t label : labels) {
+            assert(label == 0);
+        }
+    },
+    // Test 3: random merges agree with a brute force labelling, grow adds singletons, oversized structures are refused
+    []() -> void {
+        const size_t size = 300;
+        auto pairs = random_pairs(size, 200, 7);
+        util::disjoint_set_union dsu(size / 2);
+        dsu.grow(size);
+        assert(dsu.get_size() == size && dsu.get_set_count() == size);
+        dsu.merge_all(pairs);
+
+        std::vector<size_t> component(size);
+        for (size_t i = 0; i < size; ++i) component[i] = i;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const auto &[x, y] : pairs) {
+                size_t low = std::min(component[x], component[y]);
+                if (component[x] != low || component[y] != low) {
+                    component[x] = component[y] = low;
+                    changed = true;
+                }
+            }
+        }
+        std::vector<std::uint32_t> labels = dsu.compress_all();
+        std::vector<long> label_of_component(size, -1);
+        std::uint32_t next = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (label_of_component[component[i]] < 0) label_of_component[component[i]] = next++;
+            assert(labels[i] == static_cast<std::uint32_t>(label_of_component[component[i]]));
+        }
+        assert(next == dsu.get_set_count());
+
+        bool thrown = false;
+        try {
+            dsu.grow(util::disjoint_set_union::MAX_SIZE + 1);
+        } catch (const std::length_error &) {
+            thrown = true;
+        }
+        assert(thrown && dsu.get_size() == size);
+    },
+    // Test 4: sequential merges, roots are the smallest element of every set
+    []() -> void {
+        util::concurrent_disjoint_set_union dsu(10);
+        assert(dsu.size() == 10);
+        assert(dsu.merge(7, 3));
+        assert(dsu.merge(9, 7));
+        assert(!dsu.merge(3, 9));
+        assert(dsu.merge(5, 4));
+        assert(dsu.find(9) == 3);
+        assert(dsu.find(5) == 4);
+        assert(dsu.same_set(3, 9));
+        assert(!dsu.same_set(3, 4));
+        assert(dsu.find(0) == 0);
+        assert(dsu.merge(4, 9));
+        assert(dsu.find(5) == 3);
+    },
+    // Test 5: grow keeps the existing sets and adds singletons
+    []() -> void {
+        util::concurrent_disjoint_set_union dsu;
+        assert(dsu.size() == 0);
+        dsu.grow(3);
+        dsu.merge(0, 2);
+        dsu.grow(1000);
+        assert(dsu.size() == 1000);
+        assert(dsu.find(2) == 0);
+        for (size_t i = 3; i < 1000; ++i) {
+            assert(dsu.find(i) == i);
+        }
+        dsu.merge(999, 2);
+        assert(dsu.find(999) == 0);
+        dsu.reserve(5000);
+        assert(dsu.size() == 1000 && dsu.find(999) == 0);
+
+        util::concurrent_disjoint_set_union moved = std::move(dsu);
+        assert(moved.find(999) == 0 && dsu.size() == 0);
+    },
+    // Test 6: random merges from several threads give the same partition as the sequential DSU
+    []() -> void {
+        for (size_t threads : {1, 2, 8}) {
+            util::thread_pool pool(threads);
+            for (size_t size : {1, 50, 5000, 100000}) {
+                for (size_t count : {size / 4, size, size * 3}) {
+                    auto pairs = random_pairs(size, count, static_cast<unsigned>(size + count + threads));
+                    util::concurrent_disjoint_set_union dsu(size);
+                    util::disjoint_set_union reference(size);
+                    for (const auto &[x, y] : pairs) {
+                        reference.merge(x, y);
+                    }
+                    pool.parallel_for(0, pairs.size(), 64, [&](size_t first, size_t last) {
+                        for (size_t i = first; i < last; ++i) {
+                            dsu.merge(pairs[i].first, pairs[i].second);
+                        }
+                    });
+                    check_against(dsu, reference, size);
+                }
+            }
+        }
+    },
+    // Test 7: threads racing to build one long chain from both ends, interleaved with finds and same_set queries
+    []() -> void {
+        const size_t size = 200000;
+        util::thread_pool pool(8);
+        util::concurrent_disjoint_set_union dsu(size);
+        pool.parallel_for(0, size - 1, 128, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                // links (k, k + 1), alternately from the front and from the back of the chain
+                size_t x = (i % 2 == 0) ? i / 2 : size - 2 - i / 2;
+                size_t y = x + 1;
+                dsu.merge(y, x);
+                assert(dsu.same_set(x, y));
+                dsu.find(size - 1 - x);
+            }
+        });
+        for (size_t i = 0; i < size; ++i) {
+            assert(dsu.find(i) == 0);
+        }
+    },
+};
+
+int main() {
+    std::cout << "Running test_disjoint_set_union.cpp" << std::endl;
+    for (size_t i = 0; i < test_cases.size(); ++i) {
+        std::cout << "Running test case: " << i + 1 << std::endl;
+        test_cases[i]();
+    }
+    std::cout << "All test cases passed!" << std::endl;
+    return 0;
+}
@@ -1,10 +1,15 @@
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <queue>
+#include <random>
 #include <vector>
 
 #include "pcp/BinaryCSP.hpp"
 #include "pcp/BinaryDomain.hpp"
+#include "pcp/FrozenBinaryCSP.hpp"
+#include "pcp/Neighborhoods.hpp"
+#include "util/bfs_workspace.hpp"
 
 std::vector<std::function<void()>> test_cases = {
     // Test 1: 5-node cycle, alternating constraints
@@ -79,6 +84,102 @@ std::vector<std::function<void()>> test_cases = {
         auto self = pcp.get_neighbors(3, 0);
         assert(self.size() == 1);
         assert(self[0] == 3);
+    },
+    // Test 5: one workspace reused across graphs matches a plain queue based BFS
+    []() -> void {
+        util::bfs_workspace workspace;
+        std::mt19937 rng(7);
+        for (size_t size : {40, 10, 120}) {
+            pcp::BinaryCSP pcp(size);
+            std::uniform_int_distribution<size_t> dist(0, size - 1);
+            for (size_t i = 0; i < size * 2; ++i) {
+                pcp.add_constraint(dist(rng), dist(rng), constraint::BinaryConstraint::ANY);
+            }
+            for (pcp::Variable source = 0; source < size; ++source) {
+                for (int radius = 0; radius <= 4; ++radius) {
+                    // reference BFS
+                    std::vector<pcp::Variable> expected;
+                    std::vector<int> depth(size, -1);
+                    std::queue<pcp::Variable> q;
+                    q.push(source);
+                    depth[source] = 0;
+                    while (!q.empty()) {
+                        pcp::Variable current = q.front();
+                        q.pop();
+                        expected.push_back(current);
+                        if (depth[current] == radius) continue;
+                        for (const auto &[neighbor, _] : pcp.get_constraints(current)) {
+                            if (depth[neighbor] == -1) {
+                                depth[neighbor] = depth[current] + 1;
+                                q.push(neighbor);
+                            }
+                        }
+                    }
+                    assert(pcp.get_neighbors(source, radius, workspace) == expected);
+                    assert(pcp.get_neighbors(source, radius) == expected);
+                }
+            }
+        }
+    },
+    // Test 6: all_neighborhoods lists every ball in get_neighbors order
+    []() -> void {
+        std::mt19937 rng(11);
+        for (size_t size : {1, 63, 64, 150, 300}) {
+            pcp::BinaryCSP pcp(size);
+            std::uniform_int_distribution<size_t> dist(0, size - 1);
+            // sparse multigraph with self-loops and isolated variables
+            for (size_t i = 0; i < size + size / 2; ++i) {
+                pcp.add_constraint(dist(rng), dist(rng), constraint::BinaryConstraint::EQUAL);
+            }
+            pcp::FrozenBinaryCSP frozen(pcp);
+            for (int radius = 0; radius <= 6; ++radius) {
+                pcp::Neighborhoods balls = pcp.all_neighborhoods(radius);
+                pcp::Neighborhoods frozen_balls = frozen.all_neighborhoods(radius);
+                assert(balls.size() == size);
+                assert(balls.get_indices() == frozen_balls.get_indices());
+                assert(balls.get_offsets() == frozen_balls.get_offsets());
+                for (pcp::Variable u = 0; u < size; ++u) {
+                    std::vector<pcp::Variable> expected = pcp.get_neighbors(u, radius);
+                    util::span<pcp::Variable> ball = balls.get_ball(u);
+                    assert(std::vector<pcp::Variable>(ball.begin(), ball.end()) == expected);
+                }
+            }
+
+            // a sub range of sources, as used for chunked processing
+            pcp::Variable first = size / 3, last = size - size / 4;
+            pcp::Neighborhoods part = frozen.all_neighborhoods(3, first, last);
+            assert(part.size() == last - first);
+            for (pcp::Variable u = first; u < last; ++u) {
+                util::span<pcp::Variable> ball = part.get_ball(u);
+                assert(std::vector<pcp::Variable>(ball.begin(), ball.end()) == pcp.get_neighbors(u, 3));
+                assert(frozen.build_sub_pcp(ball).get_constraints_list() == pcp.get_neighboring_pcp(u, 3).get_constraints_list());
+            }
+            bool threw = false;
+            try {
+                part.get_ball(last);
+            } catch (const std::out_of_range &e) {
+                threw = true;
+            }
+            assert(threw);
+        }
+    },
+    // Test 7: a hub as the first source does not size the buffer for every other ball
+    []() -> void {
+        const size_t size = 200000;
+        pcp::BinaryCSP star(size);
+        for (pcp::Variable v = 1; v < size; ++v) {
+            star.add_constraint(0, v, constraint::BinaryConstraint::EQUAL);
+        }
+        pcp::Neighborhoods balls = star.all_neighborhoods(1);
+        assert(balls.size() == size);
+        assert(balls.get_indices().size() == size + 2 * (size - 1));
+        assert(balls.get_ball(0).size() == size);
+        for (pcp::Variable v : {pcp::Variable(1), pcp::Variable(size / 2), pcp::Variable(size - 1)}) {
+            util::span<pcp::Variable> ball = balls.get_ball(v);
+            assert(std::vector<pcp::Variable>(ball.begin(), ball.end()) == star.get_neighbors(v, 1));
+        }
+        pcp::FrozenBinaryCSP frozen(star);
+        assert(frozen.all_neighborhoods(1).get_indices() == balls.get_indices());
     }
 };
 
@@ -0,0 +1,83 @@
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "constants.hpp"
+#include "util/philox.hpp"
+#include "util/thread_pool.hpp"
+
+std::vector<std::function<void()>> test_cases = {
+    // Test 1: known answers of Philox4x32-10 from the Random123 distribution
+    []() -> void {
+        std::uint32_t out[4];
+        const std::uint32_t zero_counter[4] = {0, 0, 0, 0};
+        const std::uint32_t zero_key[2] = {0, 0};
+        util::philox::generate_block(zero_counter, zero_key, out);
+        assert(out[0] == 0x6627e8d5u && out[1] == 0xe169c58du && out[2] == 0xbc57ac4cu && out[3] == 0x9b00dbd8u);
+
+        const std::uint32_t ones_counter[4] = {~0u, ~0u, ~0u, ~0u};
+        const std::uint32_t ones_key[2] = {~0u, ~0u};
+        util::philox::generate_block(ones_counter, ones_key, out);
+        assert(out[0] == 0x408f276du && out[1] == 0x41c83b0eu && out[2] == 0xa20bc7c6u && out[3] == 0x6d5451fdu);
+
+        const std::uint32_t pi_counter[4] = {0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u};
+        const std::uint32_t pi_key[2] = {0xa4093822u, 0x299f31d0u};
+        util::philox::generate_block(pi_counter, pi_key, out);
+        assert(out[0] == 0xd16cfe09u && out[1] == 0x94fdccebu && out[2] == 0x5001e420u && out[3] == 0x24126ea1u);
+    },
+    // Test 2: a stream is the sequence of its counter blocks and different streams differ
+    []() -> void {
+        util::philox rng(0xa4093822299f31d0ull, 7, 0x0123456789abcdefull);
+        const std::uint32_t key[2] = {0x299f31d0u, 0xa4093822u};
+        for (std::uint32_t block = 0; block < 3; ++block) {
+            const std::uint32_t counter[4] = {block, 7, 0x89abcdefu, 0x01234567u};
+            std::uint32_t out[4];
+            util::philox::generate_block(counter, key, out);
+            for (std::uint32_t word : out) {
+                assert(rng() == word);
+            }
+        }
+
+        std::set<std::uint32_t> firsts;
+        for (std::uint32_t stream = 0; stream < 4; ++stream) {
+            for (std::uint64_t index = 0; index < 64; ++index) {
+                util::philox other(1, stream, index);
+                firsts.insert(other());
+            }
+        }
+        assert(firsts.size() == 4 * 64);
+        assert(util::philox::derive_key(453, 0) != util::philox::derive_key(453, 1));
+    },
+    // Test 3: streams drawn by many threads match the same streams drawn in order
+    []() -> void {
+        const size_t count = 10000;
+        std::vector<std::uint64_t> serial(count), parallel(count);
+        auto draw = [](size_t i) {
+            util::philox rng = constants::random_stream(constants::RandomStage::TESTER, i, 3);
+            std::uniform_int_distribution<std::uint64_t> dist(0, 1000000);
+            std::uint64_t sum = 0;
+            for (int k = 0; k < 10; ++k) sum = sum * 1000003 + dist(rng);
+            return sum;
+        };
+        for (size_t i = 0; i < count; ++i) serial[i] = draw(i);
+        util::thread_pool pool(8);
+        pool.parallel_for(0, count, 7, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) parallel[i] = draw(i);
+        });
+        assert(serial == parallel);
+    },
+};
+
+int main() {
+    std::cout << "Running test_philox.cpp" << std::endl;
+    for (size_t i = 0; i < test_cases.size(); ++i) {
+        std::cout << "Running test case: " << i + 1 << std::endl;
+        test_cases[i]();
+    }
+    std::cout << "All test cases passed!" << std::endl;
+    return 0;
+}
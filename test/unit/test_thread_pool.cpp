@@ -0,0 +1,134 @@
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "util/thread_pool.hpp"
+
+std::vector<std::function<void()>> test_cases = {
+    // Test 1: enqueue returns the results through futures
+    []() -> void {
+        util::thread_pool pool(4);
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 1000; ++i) {
+            futures.push_back(pool.enqueue([](int x) { return x * x; }, i));
+        }
+        for (int i = 0; i < 1000; ++i) {
+            assert(futures[i].get() == i * i);
+        }
+        auto bound = pool.enqueue([](const std::vector<int> &v, int k) { return v[k]; }, std::vector<int>{3, 5, 8}, 2);
+        assert(bound.get() == 8);
+    },
+    // Test 2: parallel_for visits every index exactly once for many range and grain combinations
+    []() -> void {
+        for (size_t threads : {1, 3, 8}) {
+            util::thread_pool pool(threads);
+            for (size_t n : {0, 1, 2, 7, 64, 1000, 4097}) {
+                for (size_t grain : {0, 1, 3, 64, 5000}) {
+                    std::vector<std::atomic<int>> hits(n + 10);
+                    pool.parallel_for(5, 5 + n, grain, [&](size_t first, size_t last) {
+                        assert(first < last && last - first <= std::max<size_t>(grain, 1));
+                        for (size_t i = first; i < last; ++i) {
+                            hits[i].fetch_add(1);
+                        }
+                    });
+                    for (size_t i = 0; i < hits.size(); ++i) {
+                        assert(hits[i].load() == (i >= 5 && i < 5 + n ? 1 : 0));
+                    }
+                }
+            }
+        }
+    },
+    // Test 3: nested parallel_for and tasks enqueued from workers do not deadlock
+    []() -> void {
+        util::thread_pool pool(4);
+        std::atomic<size_t> total{0};
+        pool.parallel_for(0, 64, 1, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                pool.parallel_for(0, 100, 7, [&](size_t a, size_t b) {
+                    total.fetch_add(b - a);
+                });
+            }
+        });
+        assert(total.load() == 6400);
+
+        auto outer = pool.enqueue([&pool]() {
+            std::future<int> inner = pool.enqueue([]() { return 7; });
+            size_t sum = 0;
+            std::mutex m;
+            pool.parallel_for(0, 1000, 10, [&](size_t a, size_t b) {
+                std::lock_guard<std::mutex> lock(m);
+                for (size_t i = a; i < b; ++i) sum += i;
+            });
+            return inner.get() + static_cast<int>(sum == 499500);
+        });
+        assert(outer.get() == 8);
+    },
+    // Test 4: exceptions reach the caller, through the future or out of parallel_for
+    []() -> void {
+        util::thread_pool pool(2);
+        auto failing = pool.enqueue([]() -> int { throw std::runtime_error("task"); });
+        bool threw = false;
+        try {
+            failing.get();
+        } catch (const std::runtime_error &e) {
+            threw = true;
+        }
+        assert(threw);
+
+        threw = false;
+        std::atomic<int> chunks{0};
+        try {
+            pool.parallel_for(0, 100, 1, [&](size_t first, size_t) {
+                chunks.fetch_add(1);
+                if (first == 37) throw std::runtime_error("chunk");
+            });
+        } catch (const std::runtime_error &e) {
+            threw = true;
+        }
+        assert(threw);
+        assert(chunks.load() == 100);
+    },
+    // Test 5: destroying the pool runs every task that was already submitted
+    []() -> void {
+        std::atomic<int> done{0};
+        {
+            util::thread_pool pool(3);
+            for (int i = 0; i < 5000; ++i) {
+                pool.enqueue([&done]() { done.fetch_add(1); });
+            }
+        }
+        assert(done.load() == 5000);
+    },
+    // Test 6: parallel_exclusive_scan matches a serial prefix sum
+    []() -> void {
+        util::thread_pool pool(4);
+        for (size_t n : {0, 1, 5, 1000, 12345}) {
+            for (size_t grain : {1, 7, 4096}) {
+                std::vector<size_t> values(n);
+                for (size_t i = 0; i < n; ++i) values[i] = (i * 7919) % 13;
+                std::vector<size_t> expected(n);
+                size_t running = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    expected[i] = running;
+                    running += values[i];
+                }
+                assert(util::parallel_exclusive_scan(pool, values, grain) == running);
+                assert(values == expected);
+            }
+        }
+    }
+};
+
+int main() {
+    for (size_t i = 0; i < test_cases.size(); ++i) {
+        test_cases[i]();
+        std::cout << "Passed test case " << (i + 1) << std::endl;
+    }
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
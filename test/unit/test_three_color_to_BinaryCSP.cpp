@@ -7,8 +7,22 @@
 #include "three_color/ThreeColor.hpp"
 #include "pcp/BinaryCSP.hpp"
 #include "pcpp/TesterFactory.hpp"
+#include "constants.hpp"
+#include "pcpp/HadamardPCPP/HadamardTester.hpp"
 #include "constraint/BinaryConstraint.hpp"
 
+namespace {
+
+size_t count_violations(const pcp::BinaryCSP &pcp) {
+    size_t violations = 0;
+    for (const auto &[u, v, c] : pcp.get_constraints_list()) {
+        violations += !constraint::evaluateBinaryConstraint(c, pcp.get_variable(u), pcp.get_variable(v));
+    }
+    return violations;
+}
+
+}
+
 std::vector<std::function<void()>> test_cases = {
     // Test 1: verify color_to_bits mapping
     []() -> void {
@@ -113,6 +127,40 @@ std::vector<std::function<void()>> test_cases = {
             }
         }
         assert(invalid_count > 0);
+    },
+    // Test 6: template gadget mode keeps valid colorings satisfiable and invalid ones violated
+    []() -> void {
+        using three_color::Color;
+        for (size_t templates : {1, 4}) {
+            three_color::ThreeColor valid = three_color::generate_valid_three_coloring_graph(300, 900, 100, 100, 100);
+            pcpp::HadamardTester tester;
+            tester.set_gadget_templates(templates);
+            assert(count_violations(tester.three_color_to_BinaryCSP(valid)) == 0);
+
+            three_color::ThreeColor invalid({Color::RED, Color::RED, Color::BLUE, Color::GREEN},
+                {{0, 1}, {1, 2}, {2, 3}, {3, 0}});
+            assert(count_violations(tester.three_color_to_BinaryCSP(invalid)) > 0);
+        }
+    },
+    // Test 7: gadgets are built in parallel from per-edge streams, so equal seeds give equal reductions
+    []() -> void {
+        three_color::ThreeColor graph = three_color::generate_invalid_three_coloring_graph(200, 600, 20, 70, 70, 60);
+        pcpp::HadamardTester tester;
+        constants::GLOBAL_SEED = 16;
+        pcp::BinaryCSP first = tester.three_color_to_BinaryCSP(graph);
+        // the thread local generator is not used by the reduction
+        constants::RANDOM_SEED.discard(7);
+        pcp::BinaryCSP second = tester.three_color_to_BinaryCSP(graph);
+        constants::GLOBAL_SEED = 17;
+        pcp::BinaryCSP other = tester.three_color_to_BinaryCSP(graph);
+        constants::GLOBAL_SEED = 453;
+        assert(first.get_constraints_list() != other.get_constraints_list());
+        assert(first.get_size() == second.get_size());
+        assert(first.get_constraints_list() == second.get_constraints_list());
+        for (pcp::Variable i = 0; i < static_cast<pcp::Variable>(first.get_size()); ++i) {
+            assert(first.get_variable(i) == second.get_variable(i));
+        }
+        assert(count_violations(first) > 0);
     }
 };
 